@@ -5,9 +5,17 @@
 //          Manual: https://github.com/mariehoffmann/PriSeT
 #pragma once
 
+#include <cerrno>
+#include <cstdlib>
+#include <algorithm>
 #include <experimental/filesystem>
+#include <initializer_list>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
 #include <unistd.h>
+#include <utility>
 
 #include "io_cfg_type.hpp"
 #include "primer_cfg_type.hpp"
@@ -23,7 +31,7 @@ namespace priset
 struct options
 {
 private:
-    std::string usage_string = "Usage: %s -l <dir_library> -w <dir_work> [-K <word_length>] [-E <errors>]\n";
+    std::string usage_string = "Usage: %s -l <dir_library> -w <dir_work> [-k <primer_min_len>:<primer_max_len>] [-x <transcript_min_len>:<transcript_max_len>] [-T <Tm_min>:<Tm_max>] [-d <dTm>] [-g <CG_min_content>:<CG_max_content>] [-p <trap_dist>] [-f <kmer_freq_percent>:<pair_freq_percent>] [-E <errors>] [-a <anchor>] [-t <threads>] [-m] [-c] [-r <sampling_rate>] [-b <bwt_bits>]\n";
 
     using size_type = primer_cfg_type::size_type;
 
@@ -39,13 +47,133 @@ private:
     // Parsed flag indicating if index re-computation shall be omitted.
     bool skip_idx{0};
 
+    // Memory-map FM index and text corpus instead of reading them.
+    bool mmap{0};
+
+    // Count k-mers by sorting instead of mapping them to the FM index (E = 0 only).
+    bool kmer_counting{0};
+
     // Number of errors allowed for k-mer.
     primer_cfg_type::size_type E{0};
 
+    // Number of 3' bases of forward primers matching exactly in approximate k-mer matches.
+    primer_cfg_type::size_type anchor{0};
+
+    // Number of threads.
+    unsigned threads{1};
+
+    // Suffix array sampling rate and BWT length width of FM index, 0 for defaults.
+    unsigned index_sampling{0};
+    unsigned index_bwt_width{0};
+
+    // kmer and kmer pair frequency cutoffs in percent of the library size.
+    std::pair<unsigned long, unsigned long> freq_min_percent;
+
+    // Primer length, transcript length and melting temperature ranges.
+    std::pair<unsigned long, unsigned long> primer_length, transcript_length, Tm;
+
+    // Relative CG content range.
+    std::pair<double, double> CG_content;
+
+    // Maximal melting temperature difference of paired primers.
+    primer_cfg_type::size_type dTm{0};
+
+    // Minimal distance between two identical kmers on same reference.
+    primer_cfg_type::size_type trap_dist{0};
+
     // Flags for initializing io configurator.
-    bool flag_lib{0}, flag_work{0};
+    bool flag_lib{0}, flag_work{0}, flag_threads{0}, flag_freq{0};
     // Flags for initializing primer configurator.
-    bool flag_E{0};
+    bool flag_E{0}, flag_anchor{0}, flag_primer_length{0}, flag_transcript_length{0}, flag_Tm{0}, flag_dTm{0}, flag_CG_content{0}, flag_trap_dist{0};
+
+    // Parse an integer in [min, max] from arg, print usage and exit otherwise.
+    unsigned long parse_integer(char const * const arg, unsigned long const min, unsigned long const max, char const * const prog)
+    {
+        char * end;
+        errno = 0;
+        unsigned long const value = strtoul(arg, &end, 10);
+        if (errno || end == arg || *end != '\0' || *arg == '-' || value < min || value > max)
+        {
+            std::cout << "ERROR: invalid argument '" << arg << "', expect integer in [" << min << ":" << max << "]" << std::endl;
+            fprintf(stderr, &usage_string[0], prog), exit(EXIT_FAILURE);
+        }
+        return value;
+    }
+
+    // Parse one of the integers in values from arg, print usage and exit otherwise.
+    unsigned long parse_integer(char const * const arg, std::initializer_list<unsigned long> const values, char const * const prog)
+    {
+        unsigned long const value = parse_integer(arg, 0, std::max(values), prog);
+        if (std::find(values.begin(), values.end(), value) == values.end())
+        {
+            std::cout << "ERROR: invalid argument '" << arg << "', expect one of";
+            for (unsigned long const v : values)
+                std::cout << " " << v;
+            std::cout << std::endl;
+            fprintf(stderr, &usage_string[0], prog), exit(EXIT_FAILURE);
+        }
+        return value;
+    }
+
+    // Parse a real number in [min, max] from arg, print usage and exit otherwise.
+    double parse_real(char const * const arg, double const min, double const max, char const * const prog)
+    {
+        char * end;
+        errno = 0;
+        double const value = strtod(arg, &end);
+        if (errno || end == arg || *end != '\0' || !(value >= min && value <= max))
+        {
+            std::cout << "ERROR: invalid argument '" << arg << "', expect number in [" << min << ":" << max << "]" << std::endl;
+            fprintf(stderr, &usage_string[0], prog), exit(EXIT_FAILURE);
+        }
+        return value;
+    }
+
+    // Split arg of the form <first>:<second>, print usage and exit otherwise.
+    std::pair<std::string, std::string> split_pair(char const * const arg, char const * const prog)
+    {
+        std::string const pair{arg};
+        size_t const colon = pair.find(':');
+        if (colon == std::string::npos)
+        {
+            std::cout << "ERROR: invalid argument '" << arg << "', expect <first>:<second>" << std::endl;
+            fprintf(stderr, &usage_string[0], prog), exit(EXIT_FAILURE);
+        }
+        return {pair.substr(0, colon), pair.substr(colon + 1)};
+    }
+
+    // Parse two integers <first>:<second> in [min, max] from arg, print usage and exit otherwise.
+    std::pair<unsigned long, unsigned long> parse_integer_pair(char const * const arg, unsigned long const min, unsigned long const max, char const * const prog)
+    {
+        auto const [first, second] = split_pair(arg, prog);
+        return {parse_integer(first.c_str(), min, max, prog), parse_integer(second.c_str(), min, max, prog)};
+    }
+
+    // Parse a non-empty range <first>:<second> of integers in [min, max] from arg, print usage and exit otherwise.
+    std::pair<unsigned long, unsigned long> parse_range(char const * const arg, unsigned long const min, unsigned long const max, char const * const prog)
+    {
+        auto const range = parse_integer_pair(arg, min, max, prog);
+        if (range.first > range.second)
+        {
+            std::cout << "ERROR: invalid argument '" << arg << "', expect non-empty range" << std::endl;
+            fprintf(stderr, &usage_string[0], prog), exit(EXIT_FAILURE);
+        }
+        return range;
+    }
+
+    // Parse a non-empty range <first>:<second> of real numbers in [min, max] from arg, print usage and exit otherwise.
+    std::pair<double, double> parse_real_range(char const * const arg, double const min, double const max, char const * const prog)
+    {
+        auto const [first, second] = split_pair(arg, prog);
+        std::pair<double, double> const range{parse_real(first.c_str(), min, max, prog), parse_real(second.c_str(), min, max, prog)};
+        if (range.first > range.second)
+        {
+            std::cout << "ERROR: invalid argument '" << arg << "', expect non-empty range" << std::endl;
+            fprintf(stderr, &usage_string[0], prog), exit(EXIT_FAILURE);
+        }
+        return range;
+    }
+
     //
     void parse_arguments(unsigned argc, char * const * argv, primer_cfg_type & primer_cfg, io_cfg_type & io_cfg)
     {
@@ -53,8 +181,9 @@ private:
         for (unsigned i = 0; i < argc; ++i) std::cout << argv[i] << " ";
         std::cout << std::endl;
 
-        // l (lib_dir), w (work_dir), i (index only), s (skip_idx), E (error), K (kmer length), colon indicates argument
-        while ((opt = getopt(argc, argv, "l:w:isE:")) != -1)
+        // l (lib_dir), w (work_dir), i (index only), s (skip_idx), E (error), a (3' anchor), t (threads), m (mmap), c (k-mer counting), r (SA sampling rate), b (BWT bits),
+        // k (primer lengths), x (transcript lengths), T (melting temperatures), d (Tm difference), g (CG content), p (trap distance), f (frequency cutoffs), colon indicates argument
+        while ((opt = getopt(argc, argv, "l:w:isE:a:t:mcr:b:k:x:T:d:g:p:f:")) != -1)
         {
             switch (opt)
             {
@@ -72,9 +201,61 @@ private:
                 case 's':
                     skip_idx = 1;
                     break;
+                case 'm':
+                    mmap = 1;
+                    break;
+                case 'c':
+                    kmer_counting = 1;
+                    break;
+                case 'r':
+                    // 0 for the default, see fm_flavour_apply for instantiated rates
+                    index_sampling = parse_integer(optarg, {0, 5, 10, 20, 40}, argv[0]);
+                    break;
+                case 'b':
+                    index_bwt_width = parse_integer(optarg, {0, 32, 64}, argv[0]);
+                    break;
                 case 'E':
                     flag_E = 1;
-                    E = atoi(optarg);
+                    E = parse_integer(optarg, 0, 4, argv[0]);
+                    break;
+                case 'a':
+                    flag_anchor = 1;
+                    // k-mers shorter than the anchor would have to match exactly, checked against
+                    // the minimal primer length by set_anchor since -k may follow
+                    anchor = parse_integer(optarg, 0, PRIMER_MAX_LEN, argv[0]);
+                    break;
+                case 't':
+                    flag_threads = 1;
+                    threads = parse_integer(optarg, 1, 1024, argv[0]);
+                    break;
+                case 'k':
+                    flag_primer_length = 1;
+                    primer_length = parse_range(optarg, PRIMER_MIN_LEN, PRIMER_MAX_LEN, argv[0]);
+                    break;
+                case 'x':
+                    flag_transcript_length = 1;
+                    transcript_length = parse_range(optarg, 1, std::numeric_limits<size_type>::max(), argv[0]);
+                    break;
+                case 'T':
+                    flag_Tm = 1;
+                    // Tm = 2AT + 4CG
+                    Tm = parse_range(optarg, 0, 4 * PRIMER_MAX_LEN, argv[0]);
+                    break;
+                case 'd':
+                    flag_dTm = 1;
+                    dTm = parse_integer(optarg, 0, 4 * PRIMER_MAX_LEN, argv[0]);
+                    break;
+                case 'g':
+                    flag_CG_content = 1;
+                    CG_content = parse_real_range(optarg, 0, 1, argv[0]);
+                    break;
+                case 'p':
+                    flag_trap_dist = 1;
+                    trap_dist = parse_integer(optarg, 0, std::numeric_limits<size_type>::max(), argv[0]);
+                    break;
+                case 'f':
+                    flag_freq = 1;
+                    freq_min_percent = parse_integer_pair(optarg, 0, 100, argv[0]);
                     break;
                 default: /* '?' */
                     std::cout << "unknown argument opt = " << opt << std::endl;
@@ -87,7 +268,29 @@ private:
         }
         // init io configurator
         io_cfg.assign(lib_dir, work_dir, idx_only, skip_idx);
-        flag_E ? primer_cfg.set_error(E) : (void) (NULL);
+        flag_threads ? io_cfg.set_threads(threads) : (void) (NULL);
+        io_cfg.set_mmap(mmap);
+        io_cfg.set_kmer_counting(kmer_counting);
+        io_cfg.set_index_sampling(index_sampling);
+        io_cfg.set_index_bwt_width(index_bwt_width);
+        flag_freq ? io_cfg.set_freq_min_percent(freq_min_percent.first, freq_min_percent.second) : (void) (NULL);
+        // init primer configurator, primer lengths first since the anchor is checked against them
+        try
+        {
+            flag_primer_length ? primer_cfg.set_primer_length(primer_length.first, primer_length.second) : (void) (NULL);
+            flag_transcript_length ? primer_cfg.set_transcript_length(transcript_length.first, transcript_length.second) : (void) (NULL);
+            flag_Tm ? primer_cfg.set_Tm(Tm.first, Tm.second) : (void) (NULL);
+            flag_dTm ? primer_cfg.set_dTm(dTm) : (void) (NULL);
+            flag_CG_content ? primer_cfg.set_CG_content(CG_content.first, CG_content.second) : (void) (NULL);
+            flag_trap_dist ? primer_cfg.set_trap_dist(trap_dist) : (void) (NULL);
+            flag_E ? primer_cfg.set_error(E) : (void) (NULL);
+            flag_anchor ? primer_cfg.set_anchor(anchor) : (void) (NULL);
+        }
+        catch (std::invalid_argument const & e)
+        {
+            std::cout << e.what() << std::endl;
+            fprintf(stderr, &usage_string[0], argv[0]), exit(EXIT_FAILURE);
+        }
     }
 
 public:
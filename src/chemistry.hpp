@@ -9,6 +9,7 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <bitset>
 #include <cassert>
 #include <cmath>
@@ -16,6 +17,8 @@
 #include <functional>
 #include <vector>
 
+#include <immintrin.h>
+
 #include <seqan/basic.h>
 
 #include "dna.hpp"
@@ -177,9 +180,39 @@ std::string bits2str(uint_type i);
 
 std::string kmerID2str(TKmerID kmerID);
 
+// Selects the lower bit of each base in a 2-bit code.
+#define BASE_LOW_BITS 0x5555555555555555ULL
+
+/*
+ * Mark the bases of a code equal to the base d positions before by their lower
+ * bit. The first d bases and the stop symbol are never marked.
+ */
+extern inline uint64_t equal_bases(uint64_t const code, uint64_t const l_enc, uint64_t const d)
+{
+    uint64_t const diff = code ^ (code >> (d << 1));
+    return ~(diff | (diff >> 1)) & BASE_LOW_BITS & ((1ULL << (l_enc - (d << 1))) - 1);
+}
+
+/*
+ * Reset the length bits of all kmers containing a motif, given the bases at which
+ * a motif ends marked by their lower bit. The first marked base determines the
+ * shortest kmer length to discard.
+ */
+extern inline uint64_t erase_motif_bits(uint64_t prefix, uint64_t const l_enc, uint64_t const ends)
+{
+    if (!ends)
+        return prefix;
+    // encoded length of shortest kmer containing a motif
+    uint64_t const k = l_enc - (WORD_SIZE - 1 - __builtin_clzll(ends));
+    return erase_bits(prefix, k);
+}
+
 /*
  * This filter is one of many filters applied sequentially. Therefore, it is
  * possible that the prefix is reset completely by previous operations.
+ * Runs of 5 equal bases and di-nucleotide repeats of length 10 are detected at
+ * once for all kmer lengths by comparing the code with itself shifted by 1 and
+ * 2 bases, and searching runs of equal bases in the result.
  * TODO: shorten di-nucleotide runs to at most 4 due to self-annealing
  * Filters also a subset of self-annealing structures.
  */
@@ -192,43 +225,18 @@ extern inline void filter_repeats_runs(TKmerID & kmerID)
     {
         return;
     }
-    uint64_t const tail_selector_10 = (1 << 10) - 1;
-    uint64_t const tail_selector_20 = (1 << 20) - 1;
-    kmerID = code; // save trimmed kmer-code part
-    uint64_t k = encoded_length(code);
-    uint64_t tail_10;
-    while (code >= (1 << 10))
-    {
-        tail_10 = tail_selector_10 & code;
-        // XOR tail with A_5, C_5, G_5, T_5
-        if ((tail_10 == 0b0000000000) || (tail_10 == 0b0101010101) || (tail_10 == 0b1010101010) || (tail_10 == 0b1111111111))
-        {
-            prefix = erase_bits(prefix, k);
-        }
-        // at least 10 characters left to test for di-nucleotide repeats of length 5
-        if (code >= (1ULL << 20))
-        {
-            uint64_t tail_20 = code & tail_selector_20;
-            // AT_5, TA_5, AC_5, CA_5, AG_5, GA_5, CG_5, GC_5, CT_5, TC_5, GT_5, TG_5
-            if ( (tail_20 == 0b00110011001100110011) || (tail_20 == 0b11001100110011001100) ||
-                 (tail_20 == 0b00010001000100010001) || (tail_20 == 0b01000100010001000100) ||
-                 (tail_20 == 0b00100010001000100010) || (tail_20 == 0b10001000100010001000) ||
-                 (tail_20 == 0b01100110011001100110) || (tail_20 == 0b10011001100110011001) ||
-                 (tail_20 == 0b01110111011101110111) || (tail_20 == 0b11011101110111011101) ||
-                 (tail_20 == 0b10111011101110111011) || (tail_20 == 0b11101110111011101110))
-            {
-                // delete all k bits ≥ len_selector
-                prefix = erase_bits(prefix, k);
-            }
-        }
-        if (!prefix)
-            break;
-
-        ----k;
-        code >>= 2;
-    }
-    // add updated prefix
-    kmerID |= prefix;
+    uint64_t const l_enc = encoded_length(code);
+    // A_5, C_5, G_5, T_5 end at a base equal to its 4 predecessors
+    uint64_t runs = equal_bases(code, l_enc, 1);
+    runs &= runs >> 2;
+    runs &= runs >> 4;
+    // di-nucleotide repeats like AT_5 end at a base where the last 8 bases equal
+    // the bases 2 positions before
+    uint64_t repeats = equal_bases(code, l_enc, 2);
+    repeats &= repeats >> 2;
+    repeats &= repeats >> 4;
+    repeats &= repeats >> 8;
+    kmerID = erase_motif_bits(prefix, l_enc, runs | repeats) | code;
 }
 
 // Check if not more than 3 out of the 5 last bases at the 3' end are CG.
@@ -579,92 +587,158 @@ extern inline void filter_cross_annealing(TKmerID & kmerID1, TKmerID & kmerID2)
     }
 }
 
+// Bit mask of the C and G bases in a 2-bit code. C = 01 and G = 10 are the only
+// codes with differing bits, the mask has the lower bit of each such base set.
+#define CG_BITS(code) (((code) ^ ((code) >> 1)) & BASE_LOW_BITS)
+
 /*
- * Filter kmers based on their chemical properties regardless of their pairing.
- * This is a metafunction performing several single pass checks:
- *   1. melting tempaerature
- *   2. CG content
- *   3. di-nucleotide repeats
- *   4. consecutive runs
- * Length bits in prefix of kmerID are reset in case of not passing.
- * This function only modifies the prefix.
- * Precondition: kmerID_ trimmed to largest prefix encoded length
- * Output: kmerID trimmed to largest length bit
+ * TATA box test for all prefixes of a kmer. Length bits of kmers containing the
+ * motif TATA or ATAT are reset. Both end at an A or T base which differs from its
+ * predecessor, where the last 2 bases are A or T and equal the 2 bases before.
  */
-void chemical_filter_single_pass(TKmerID & kmerID)
+extern inline void filter_TATA_box(TKmerID & kmerID)
 {
-    // TKmerID code = kmerID & ~PREFIX_SELECTOR;
     auto [prefix, code] = split_kmerID(kmerID);
     if (!prefix)
-    {
         return;
-    }
-    assert(kmerID > 0 && code > 0);
-    uint8_t AT = 0; // counter 'A'|'T'
-    uint8_t CG = 0; // counter 'C'|'G'
+    uint64_t const l_enc = encoded_length(code);
+    // A = 00 and T = 11 are the only codes with equal bits
+    uint64_t const AT = ~CG_BITS(code) & BASE_LOW_BITS;
+    uint64_t tata = equal_bases(code, l_enc, 2);
+    tata &= (tata >> 2) & AT & (AT >> 2) & ~equal_bases(code, l_enc, 1);
+    kmerID = erase_motif_bits(prefix, l_enc, tata) | code;
+}
 
-    uint64_t enc_l = encoded_length(kmerID);
-    // sum CG, AT content for longest kmer
-    while (code != 1)
+/*
+ * Melting temperature and CG content of a kmer of length K depend only on its
+ * number of C and G bases, and are monotone in it. For each K the CG counts with
+ * both values in the ranges of primer_cfg form an interval [lo[K], hi[K]], which
+ * is empty (lo > hi) if no kmer of length K passes. The bounds are derived with
+ * the same expressions as the per kmer checks, hence give identical results at the
+ * range limits.
+ */
+struct TCGBounds
+{
+    std::array<uint8_t, PRIMER_MAX_LEN + 1> lo{};
+    std::array<uint8_t, PRIMER_MAX_LEN + 1> hi{};
+
+    TCGBounds() : TCGBounds(primer_cfg_type{}) {}
+
+    explicit TCGBounds(primer_cfg_type const & primer_cfg)
     {
-        switch(3 & code)
-        {
-            case 1:
-            case 2: ++CG; break;
-            default: ++AT;
-        }
-        // TATA box test
-        if ((code > (1ULL << 9)) && (((code & 0b11111111) == 0b11001100) || ((code & 0b11111111) == 0b00110011)))
+        for (uint64_t K = PRIMER_MIN_LEN; K <= PRIMER_MAX_LEN; ++K)
         {
-            if (enc_l <= PRIMER_MIN_LEN) // delete all length bits to discard this kmer
+            lo[K] = K + 1;
+            hi[K] = 0;
+            for (uint64_t CG = 0; CG <= K; ++CG)
             {
-                kmerID &= ~PREFIX_SELECTOR;
-                // std::cout << "TATA box found\n";
-                return;
-            }
-            else // delete all length bits between current encoded length and larger ones
-            {
-                prefix &= ~((1ULL << (WORD_SIZE - enc_l + PRIMER_MIN_LEN)) - 1);
+                uint64_t const AT = K - CG;
+                auto const Tm = (AT << 1) + (CG << 2);
+                float const CG_content = float(CG) / float(K);
+                if (Tm < primer_cfg.get_min_Tm() || Tm > primer_cfg.get_max_Tm() ||
+                    CG_content < primer_cfg.get_CG_min_content() || CG_content > primer_cfg.get_CG_max_content())
+                    continue;
+                lo[K] = std::min<uint64_t>(lo[K], CG);
+                hi[K] = CG;
             }
         }
-        if (!prefix)
-            return;
-        code >>= 2;
-        --enc_l;
     }
-    code = kmerID & ~PREFIX_SELECTOR;
-    kmerID = prefix | code;
-    // start with largest kmer
-    uint64_t tailing_zeros = ffsll(prefix >> 54) - 1;
-    uint64_t mask = 1ULL << (54 + tailing_zeros);
-    for (uint8_t i = 0; i < 10 - tailing_zeros; ++i)
+};
+
+// Bounds for the default primer settings.
+inline TCGBounds const & cg_bounds()
+{
+    static TCGBounds const bounds{};
+    return bounds;
+}
+
+/*
+ * Reset length bits of kmers with melting temperature or CG content out of range,
+ * and of lengths outside of TLengths. The CG count of each length is the popcount
+ * of the CG mask of its leading bases.
+ */
+template<typename TLengths = TPrimerLengthsFull>
+inline void filter_Tm_CG(TKmerID & kmerID, TCGBounds const & bounds = cg_bounds())
+{
+    auto [prefix, code] = split_kmerID(kmerID);
+    if (!prefix)
+        return;
+    uint64_t const l_enc = encoded_length(code);
+    uint64_t const cg_bits = CG_BITS(code) & ((1ULL << l_enc) - 1);
+    uint64_t passed{0};
+    for (uint64_t K = TLengths::MIN_LEN; K <= std::min<uint64_t>(l_enc >> 1, TLengths::MAX_LEN); ++K)
     {
-        if (kmerID & mask)
+        uint64_t const CG = __builtin_popcountll(cg_bits >> (l_enc - (K << 1)));
+        if (bounds.lo[K] <= CG && CG <= bounds.hi[K])
+            passed |= ONE_LSHIFT_63 >> (K - PRIMER_MIN_LEN);
+    }
+    kmerID &= passed | ~PREFIX_SELECTOR;
+}
+
+/*
+ * AVX2 variant of filter_Tm_CG for 4 kmerIDs per step. The lanes accumulate the
+ * CG counts of all prefix lengths base by base and compare them with the bounds
+ * of each length in TLengths. Lanes with an empty prefix are passed through
+ * unchanged. The remainder is filtered by the scalar variant.
+ */
+template<typename TLengths = TPrimerLengthsFull>
+__attribute__((target("avx2")))
+inline void filter_Tm_CG_avx2(TKmerID * const kmerIDs, uint64_t const n, TCGBounds const & bounds = cg_bounds())
+{
+    __m256i const one = _mm256_set1_epi64x(1);
+    __m256i const two = _mm256_set1_epi64x(2);
+    __m256i const code_selector = _mm256_set1_epi64x(~PREFIX_SELECTOR);
+    uint64_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        alignas(32) uint64_t cg_bits[4], shifts[4];
+        for (uint64_t j = 0; j < 4; ++j)
         {
-            // reset bit if Tm out of range
-            auto Tm = (AT << 1) + (CG << 2);
-            if (Tm < PRIMER_MIN_TM || Tm > PRIMER_MAX_TM)
-            {
-                kmerID ^= mask;
-            }
-            else
-            {
-                float CG_content = float(CG) / (float(__builtin_clzl(mask) + PRIMER_MIN_LEN));
-                if (CG_content < CG_MIN_CONTENT || CG_content > CG_MAX_CONTENT)
-                {
-                    kmerID ^= mask;
-                }
-            }
+            uint64_t const code = kmerIDs[i + j] & ~PREFIX_SELECTOR;
+            shifts[j] = (code && (kmerIDs[i + j] & PREFIX_SELECTOR)) ? encoded_length(code) : 0;
+            cg_bits[j] = CG_BITS(code) & ((1ULL << shifts[j]) - 1);
         }
-        switch(3 & code)
+        __m256i const cg = _mm256_load_si256(reinterpret_cast<__m256i const *>(cg_bits));
+        __m256i shift = _mm256_load_si256(reinterpret_cast<__m256i const *>(shifts));
+        __m256i count = _mm256_setzero_si256();
+        __m256i passed = code_selector;
+        for (uint64_t K = 1; K <= TLengths::MAX_LEN; ++K)
         {
-            case 1:
-            case 2: --CG; break;
-            default: --AT;
+            // shifts beyond the encoded length wrap around and yield zero
+            shift = _mm256_sub_epi64(shift, two);
+            count = _mm256_add_epi64(count, _mm256_and_si256(_mm256_srlv_epi64(cg, shift), one));
+            if (K < TLengths::MIN_LEN)
+                continue;
+            __m256i const out_of_range = _mm256_or_si256(_mm256_cmpgt_epi64(_mm256_set1_epi64x(bounds.lo[K]), count),
+                                                         _mm256_cmpgt_epi64(count, _mm256_set1_epi64x(bounds.hi[K])));
+            passed = _mm256_or_si256(passed, _mm256_andnot_si256(out_of_range, _mm256_set1_epi64x(ONE_LSHIFT_63 >> (K - PRIMER_MIN_LEN))));
         }
-        code >>= 2;
-        mask <<= 1;
+        __m256i * const dst = reinterpret_cast<__m256i *>(kmerIDs + i);
+        _mm256_storeu_si256(dst, _mm256_and_si256(_mm256_loadu_si256(dst), passed));
     }
+    for (; i < n; ++i)
+        filter_Tm_CG<TLengths>(kmerIDs[i], bounds);
+}
+
+/*
+ * Filter kmers based on their chemical properties regardless of their pairing.
+ * This is a metafunction performing several single pass checks:
+ *   1. TATA box
+ *   2. melting tempaerature
+ *   3. CG content
+ *   4. di-nucleotide repeats
+ *   5. consecutive runs
+ *   6. self-annealing
+ * Length bits in prefix of kmerID are reset in case of not passing.
+ * This function only modifies the prefix.
+ * Precondition: kmerID_ trimmed to largest prefix encoded length
+ */
+void chemical_filter_single_pass(TKmerID & kmerID)
+{
+    filter_TATA_box(kmerID);
+    filter_Tm_CG(kmerID);
+    if (!(kmerID & PREFIX_SELECTOR))
+        return;
 
     // Filter di-nucleotide repeats and
     filter_repeats_runs(kmerID);
@@ -675,6 +749,33 @@ void chemical_filter_single_pass(TKmerID & kmerID)
     filter_annealing_disconnected(kmerID);
 }
 
+/*
+ * Batched variant of chemical_filter_single_pass for the n kmerIDs starting at
+ * kmerIDs with identical results for the default primer settings. Length bits
+ * outside of TLengths are reset. The melting temperature and CG content checks of
+ * all kmer lengths are vectorized across kmerIDs if the CPU supports AVX2.
+ */
+template<typename TLengths = TPrimerLengthsFull>
+void chemical_filter_batch(TKmerID * const kmerIDs, uint64_t const n, TCGBounds const & bounds = cg_bounds())
+{
+    static bool const avx2 = __builtin_cpu_supports("avx2");
+    for (uint64_t i = 0; i < n; ++i)
+        filter_TATA_box(kmerIDs[i]);
+    if (avx2)
+        filter_Tm_CG_avx2<TLengths>(kmerIDs, n, bounds);
+    else
+        for (uint64_t i = 0; i < n; ++i)
+            filter_Tm_CG<TLengths>(kmerIDs[i], bounds);
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        if (!(kmerIDs[i] & PREFIX_SELECTOR))
+            continue;
+        filter_repeats_runs(kmerIDs[i]);
+        filter_annealing_connected(kmerIDs[i]);
+        filter_annealing_disconnected(kmerIDs[i]);
+    }
+}
+
 
 /* Helper function for computing the convolution of two sequences. For each overlap
  *position the Gibb's free energy is computed and the minimum returned;
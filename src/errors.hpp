@@ -15,3 +15,5 @@
 #define WRK_DIR_ERROR -5
 #define FORK_ERROR -6
 #define EXECV_ERROR -7
+#define IDX_WRITE_ERROR -8
+#define IDX_FLAVOUR_ERROR -9
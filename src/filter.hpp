@@ -5,14 +5,23 @@
 #include <cmath>
 #include <fstream>
 #include <functional>
+#include <future>
+#include <iterator>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "../submodules/genmap/src/common.hpp"
 #include "../submodules/genmap/src/genmap_helper.hpp"
 #include "../submodules/sdsl-lite/include/sdsl/bit_vectors.hpp"
 
 #include "combine_types.hpp"
+#include "fm.hpp"
+#include "kmer_attributes.hpp"
+#include "kmer_id_store.hpp"
+#include "length_mask_store.hpp"
+#include "location_store.hpp"
 #include "primer_cfg_type.hpp"
 #include "types.hpp"
 #include "utilities.hpp"
@@ -20,255 +29,396 @@
 namespace priset
 {
 
-// Filter of single kmers and transform of references to bit vectors.
-void filter_and_transform(io_cfg_type const & io_cfg, TKLocations const & locations, TReferences & references, TSeqNoMap & seqNoMap, TKmerIDs & kmerIDs)
-{
-    // uniqueness indirectly preserved by (SeqNo, SeqPos) if list sorted lexicographically
-    assert(length(locations));
-
-    references.clear();
-    kmerIDs.clear();
+// Bit of the length mask marking a dropped location, above are the 10 length bits.
+#define LENGTH_MASK_DROP 1U
 
-    // frequency cutoff for k-mer occurences
-    unsigned const freq_kmer_min = io_cfg.get_freq_kmer_min();
-
-    // load corpus for dna to 64 bit conversion
-    seqan::StringSet<seqan::DnaString, seqan::Owner<seqan::ConcatDirect<>>> text;
-    fs::path text_path = io_cfg.get_index_txt_path();
-    seqan::open(text, text_path.string().c_str(), seqan::OPEN_RDONLY);
-    if (!seqan::lengthSum(text))
-        throw std::length_error("Reference text size is 0!");
-    // (i) collect distinct sequence identifiers and maximal position of kmer occurences
-    // to have a compressed representation.
-    std::map<TSeqNo, TSeqPos> seqNo2maxPos;
-    for (typename TKLocations::const_iterator it = locations.cbegin(); it != locations.cend(); ++it)
+/*
+ * Length masks of k-mer locations partitioned by reference, bucket seqNo holds the
+ * masks of the k-mer locations of sequence seqNo indexed by their rank, see
+ * filter_locations. A mask has the length bits of the later kmerID prefix
+ * shifted by one (bit 10 for PRIMER_MIN_LEN) and the drop bit LENGTH_MASK_DROP.
+ * The rank of a non-empty bucket is the compressed sequence identifier seqNo_cx.
+ */
+using TLengthMasks = std::vector<TReferenceMasks>;
+
+/*
+ * Filter of single kmers. OR the length bit of K into the masks of the locations
+ * of a frequent k-mer, k-mers with lengths outside of the primer length range are
+ * skipped. If a k-mer occurs again within the trap distance in the same reference,
+ * both locations are dropped. A drop is marked by LENGTH_MASK_DROP and wins over
+ * length bits set by other k-mers, no matter in which order the k-mers are
+ * registered.
+ */
+template<typename TLocationList>
+void filter_locations(primer_cfg_type const & primer_cfg, TKmerLength const K, TLocationList const & locs, TLengthMasks & masks)
+{
+    if (K < primer_cfg.get_primer_min_len() || K > primer_cfg.get_primer_max_len())
+        return;
+    TSeqPos const trap_dist = primer_cfg.get_trap_dist();
+    uint16_t const length_bit = (ONE_LSHIFT_63 >> (K - PRIMER_MIN_LEN)) >> (WORD_SIZE - PREFIX_SIZE - 1);
+    bool first{1};
+    TSeqNo seqNo_prev{0};
+    TSeqPos seqPos_prev{0};
+    TReferenceMasks * reference{nullptr};
+    for (TLocation const loc : locs)
     {
-        // resetLimits in mapper may lead to empty kmer occurrences
-        if ((it->second).first.size() < freq_kmer_min)
+        TSeqNo seqNo = seqan::getValueI1<TSeqNo, TSeqPos>(loc);
+        TSeqPos seqPos = seqan::getValueI2<TSeqNo, TSeqPos>(loc);
+        if (first || seqNo_prev != seqNo)
         {
-            continue;
+            if (seqNo >= masks.size())
+                masks.resize(seqNo + 1);
+            reference = &masks[seqNo];
         }
+        // drop current and previous location if same kmer occurs within 400 bp,
+        // the current one is not registered
+        if (!first && seqNo_prev == seqNo && seqPos_prev + trap_dist >= seqPos)
+            reference->add(seqPos_prev, LENGTH_MASK_DROP);
+        else
+            reference->add(seqPos, length_bit);
+        first = 0;
+        seqNo_prev = seqNo;
+        seqPos_prev = seqPos;
+    }
+}
 
-        // it->first contained in list it->second, so we iterate only over list
-        TSeqNo seqNo;
-        TSeqPos seqPos;
-        for (std::vector<TLocation>::const_iterator it_loc_fwd = it->second.first.begin(); it_loc_fwd != it->second.first.end(); ++it_loc_fwd)
+/*
+ * Transform one reference: encode the kmers of the locations kept in its length
+ * masks in order of their positions and filter them as one batch. The sequence is
+ * a view into the corpus and read once left to right. The masks are merged,
+ * scanned in order of their ranks and released afterwards. The positions of kmers
+ * passing the filter are returned next to their kmerIDs.
+ */
+template<typename TLengths, typename TSequence>
+void transform_reference(TSequence const & sequence, TReferenceMasks & masks, TCGBounds const & bounds, std::vector<TKmerID> & kmerIDs_reference, std::vector<TSeqPos> & positions)
+{
+    // (ii) collect positions of kmer occurrences that were not dropped
+    masks.merge();
+    positions.clear();
+    std::vector<uint16_t> kept;
+    kept.reserve(masks.size());
+    sdsl::bit_vector const & candidates = masks.candidates();
+    uint64_t candidate{0};
+    for (uint64_t word = 0; word < ((candidates.size() + 63) >> 6); ++word)
+    {
+        for (uint64_t bits = candidates.data()[word]; bits; bits &= bits - 1, ++candidate)
         {
-            seqNo = seqan::getValueI1<TSeqNo, TSeqPos>(*it_loc_fwd);
-            seqPos = seqan::getValueI2<TSeqNo, TSeqPos>(*it_loc_fwd);
-            if (seqNo2maxPos.find(seqNo) == seqNo2maxPos.end())
-                seqNo2maxPos[seqNo] = seqPos;
-            else
-                seqNo2maxPos[seqNo] = std::max(seqNo2maxPos[seqNo], seqPos);
+            uint16_t const mask = masks[candidate];
+            if (!(mask & LENGTH_MASK_DROP))
+            {
+                positions.push_back((word << 6) + __builtin_ctzll(bits));
+                kept.push_back(mask >> 1);
+            }
         }
     }
+    masks.clear();
+
+    // (iii) encode kmer sequences as 64 bit integers in a single scan. The rolling
+    // window holds the 2-bit codes of the last 32 bases before window_end, the
+    // first base in the most significant bits as in dna_encoder. Bases other than
+    // A, C, G and T (N in Dna5 sequences) are encoded as A like in dna_encoder.
+    kmerIDs_reference.resize(kept.size());
+    uint64_t window{0};
+    TSeqPos window_end{0};
+    for (uint64_t rank = 0; rank < kept.size(); ++rank)
+    {
+        TSeqPos const seqPos = positions[rank];
 
-    std::set<TSeqNo> seqNos;
-    for (auto it = seqNo2maxPos.cbegin(); it != seqNo2maxPos.cend(); ++it)
-        seqNos.insert(it->first);
+        // get kmerID prefix, length masks are non-zero by construction
+        TKmerID kmerID = uint64_t(kept[rank]) << (WORD_SIZE - PREFIX_SIZE);
 
-    TSeqNo seqNo_cx = 0;
-    // store seqNo -> seqNo_cx and (1<<63 | seqNo_cx) -> seqNo (we never have more than 2^63 sequences)
-    for (auto seqNo : seqNos)
-    {
-        seqNoMap[seqNo] = seqNo_cx++;
-        seqNoMap[ONE_LSHIFT_63 | seqNoMap[seqNo]] = seqNo;
-    }
+        // identify lowest set bit in prefix
+        TKmerLength k_max = PRIMER_MAX_LEN - ffsll(kmerID >> 54) + 1;
 
-    // (ii) Create bit vectors in the length of largest kmer occurences, and set
-    // bits for kmer occurrences. Collect also kmer lengths encoded in final kmer
-    // code of type uint64_t. Final sequence lookup and encoding is done in next step.
+        // slide window up to the end of the longest k-mer at this position
+        for (; window_end < seqPos + k_max; ++window_end)
+        {
+            uint64_t const c = seqan::ordValue(sequence[window_end]);
+            window = (window << 2) | (c > 3 ? 0 : c);
+        }
 
-    // reserve space for bit vectors
-    references.resize(seqNo2maxPos.size());
-    for (auto it = seqNo2maxPos.cbegin(); it != seqNo2maxPos.cend(); ++it)
-    {
-        sdsl::bit_vector bv(it->second + 1, 0);
-        references[seqNoMap[it->first]] = bv;
+        // append encoded, longest k-mer for this position with stop symbol 'C' = 1
+        uint64_t const code_mask = (1ULL << (k_max << 1)) - 1;
+        kmerID |= ((window >> ((window_end - seqPos - k_max) << 1)) & code_mask) | (code_mask + 1);
+        kmerIDs_reference[rank] = kmerID;
     }
 
-    // set bits for kmers in references and collect Ks
-    // bit 0: set if kmer of length primer_length_min found ...
-    // bit primer_length_max-primer_length_min: set if kmer of length primer_length_max found
-    // => maximal encodable length difference is 16!
-    std::unordered_map<uint64_t, uint64_t> loc2k;
-    kmerIDs.resize(references.size());
-    std::vector<uint32_t> debug_drop_kmer_repeats(references.size(), 0);
+    // (iv) erase those length bits in prefix corresponding to kmers not passing the filter
+    chemical_filter_batch<TLengths>(kmerIDs_reference.data(), kmerIDs_reference.size(), bounds);
 
-    for (typename TKLocations::const_iterator it = locations.cbegin(); it != locations.cend(); ++it)
+    // do not store kmers without length bits
+    uint64_t passed{0};
+    for (uint64_t i = 0; i < kmerIDs_reference.size(); ++i)
     {
-        // cleanup in mapper may lead to undercounting kmer occurrences
-        // TODO: move kmer frequency cutoff completely into mapper
-        if ((it->second).first.size() < freq_kmer_min)
-             continue;
-
-        const auto & [seqNo, seqPos, K] = (it->first);
-        // use symmetry and lexicographical ordering of locations to skip already seen ones
-        // TODO: is this already shortcut fm mapper?
-        if (it->second.first.size() && (seqan::getValueI1<TSeqNo, TSeqPos>(it->second.first[0]) < seqNo ||
-            (seqan::getValueI1<TSeqNo, TSeqPos>(it->second.first[0]) == seqNo &&
-            seqan::getValueI2<TSeqNo, TSeqPos>(it->second.first[0]) < seqPos)))
+        if (PREFIX_SELECTOR & kmerIDs_reference[i])
         {
-            std::cout << "WARNING: symmetry of location ordering not exploited! Fix this in mapper.\n";
-            continue;
+            positions[passed] = positions[i];
+            kmerIDs_reference[passed++] = kmerIDs_reference[i];
         }
-        // insert now unique occurrences listed in first vector (forward mappings)
-        TSeqNo seqNo_prev{0};
-        TSeqPos seqPos_prev{0};
-        for (std::vector<TLocation>::const_iterator it_loc_fwd = it->second.first.cbegin(); it_loc_fwd != it->second.first.cend(); ++it_loc_fwd)
-        {
-            TSeqNo seqNo = seqan::getValueI1<TSeqNo, TSeqPos>(*it_loc_fwd);
-            TSeqPos seqPos = seqan::getValueI2<TSeqNo, TSeqPos>(*it_loc_fwd);
-            // continue and delete previous bit if same kmer occurs within 400 bp
-            if (it_loc_fwd > it->second.first.begin() && seqNo_prev == seqNo && seqPos_prev + TRAP_DIST >= seqPos)
-            {
-                seqan::DnaString seq = seqan::valueById(text, seqNo);
-                // undo previous kmer bit in reference
-                references[seqNoMap[seqNo]][seqPos_prev] = 0;
-                seqPos_prev = seqPos;
-                debug_drop_kmer_repeats[seqNo]++;
-                continue;
-            }
+    }
+    kmerIDs_reference.resize(passed);
+    positions.resize(passed);
+}
 
-            if (references.size() <= seqNoMap[seqNo] || references[seqNoMap[seqNo]].size() <= seqPos)
-            {
-                if (references.size() > seqNoMap[seqNo])
-                    std::cout << "seqPos = " << seqPos << " and references[seqNo].size() = " << references[seqNoMap[seqNo]].size() << std::endl;
-                continue;
-            }
+/*
+ * Lookup kmer sequences of the locations kept in masks, filter and encode them as
+ * 64 bit integers and store them with their positions in kmerIDs. References are
+ * independent and transformed on `threads` threads, each writes only its own
+ * entries, hence the result equals the sequential one. Kmers are filtered with
+ * the kernels for primer lengths TLengths and the Tm and CG content bounds of
+ * primer_cfg.
+ */
+template<typename TLengths, typename TText>
+void transform(TText const & text, TLengthMasks & masks, primer_cfg_type const & primer_cfg, unsigned const threads, TSeqNoMap & seqNoMap, TKmerIDs & kmerIDs)
+{
+    kmerIDs.clear();
 
-            references[seqNoMap[seqNo]][seqPos] = 1;
-
-            uint64_t loc_key = location_encode(seqNoMap[seqNo], seqPos);
-            uint64_t loc_val = ONE_LSHIFT_63 >> (K - PRIMER_MIN_LEN); // later prefix of kmerID
-            // locations filled for K_min to K_max
-            if (loc2k.find(loc_key) == loc2k.end())
-                loc2k.insert({loc_key, loc_val});
-            else // update
-                loc2k[loc_key] |= loc_val;
-            seqNo_prev = seqNo;
-            seqPos_prev = seqPos;
-        }
+    // (i) compressed representation of distinct sequence identifiers in the order of seqNo
+    seqNoMap.clear();
+    for (TSeqNo seqNo = 0; seqNo < masks.size(); ++seqNo)
+    {
+        if (!masks[seqNo].empty())
+            seqNoMap.push_back(seqNo);
+    }
+
+    // (ii, iii) per reference, note: we iterate over compressed sequence identifiers
+    std::vector<std::vector<TKmerID> > kmerIDs_per_reference(seqNoMap.size());
+    std::vector<std::vector<TSeqPos> > positions_per_reference(seqNoMap.size());
+    TCGBounds const bounds{primer_cfg};
+    parallel_for(seqNoMap.size(), threads, [&](uint64_t const seqNo_cx, unsigned const)
+    {
+        TSeqNo const seqNo = seqNoMap.seqNo(seqNo_cx);
+        transform_reference<TLengths>(seqan::valueById(text, seqNo), masks[seqNo], bounds, kmerIDs_per_reference[seqNo_cx], positions_per_reference[seqNo_cx]);
+    });
+    masks.clear();
+
+    // concatenate kmerIDs and their positions in order of seqNo_cx
+    for (uint64_t seqNo_cx = 0; seqNo_cx < seqNoMap.size(); ++seqNo_cx)
+    {
+        kmerIDs.append_reference(kmerIDs_per_reference[seqNo_cx].begin(), kmerIDs_per_reference[seqNo_cx].end(), positions_per_reference[seqNo_cx].begin());
+        std::vector<TKmerID>().swap(kmerIDs_per_reference[seqNo_cx]);
+        std::vector<TSeqPos>().swap(positions_per_reference[seqNo_cx]);
     }
+}
 
-    /* print drop out statistics */
-    // for (unsigned i = 0; i < debug_drop_kmer_repeats.size(); ++i)
-    // {
-    //     if (debug_drop_kmer_repeats[i])
-    //         std::cerr << "seqNo = " << i << ", dropouts: " << int(debug_drop_kmer_repeats[i]) << std::endl;
-    // }
-    // (iii) lookup kmer sequences, filter and encode as 64 bit integers.
-    for (TSeqNo seqNo_cx = 0; seqNo_cx < references.size(); ++seqNo_cx) // Note: we iterate over compressed sequence identifiers
+// Load corpus for dna to 64 bit conversion and transform with the kernels for the primer length range.
+void transform(io_cfg_type const & io_cfg, primer_cfg_type const & primer_cfg, TLengthMasks & masks, TSeqNoMap & seqNoMap, TKmerIDs & kmerIDs)
+{
+    primer_length_apply(primer_cfg, [&](auto lengths)
     {
-        // std::cout << "STATUS: bit vector assignment for seqNo_cx = " << seqNo_cx << std::endl;
-        sdsl::rank_support_v5<1> r1s(&references[seqNo_cx]); // check if once initialized modification of references[i] does not invalidate rank support
-        sdsl::select_support_mcl<1,1> s1s(&references[seqNo_cx]);
-        for (unsigned r = r1s.rank(references[seqNo_cx].size()); r > 0; --r)
+        text_apply(io_cfg, [&](auto const & text)
         {
-            TSeqPos seqPos = s1s.select(r);
-            uint64_t loc_key = location_encode(seqNo_cx, seqPos);
+            transform<decltype(lengths)>(text, masks, primer_cfg, io_cfg.get_threads(), seqNoMap, kmerIDs);
+        });
+    });
+}
 
-            // get kmerID prefix
-            TKmerID kmerID = loc2k[loc_key];
-            if (!kmerID)
-                throw std::invalid_argument("ERROR: prefix is 0!");
+// Filter of single kmers and transform of kept kmer locations to kmerIDs.
+void filter_and_transform(io_cfg_type const & io_cfg, primer_cfg_type const & primer_cfg, TKLocations const & locations, TSeqNoMap & seqNoMap, TKmerIDs & kmerIDs)
+{
+    assert(!locations.empty());
 
-            // identify lowest set bit in prefix
-            TKmerLength k_max = PRIMER_MAX_LEN - ffsll(kmerID >> 54) + 1;
+    // the mapper emits one k-mer group per k-mer interval with at least
+    // io_cfg.get_freq_kmer_min() occurrences, each is filtered once
+    TLengthMasks masks;
+    for (uint64_t group = 0; group < locations.groups(); ++group)
+        filter_locations(primer_cfg, locations.group_length(group), locations.group_locations(group), masks);
 
-            // lookup sequence in corpus and encode
-            seqan::DnaString seq = seqan::valueById(text, seqNoMap.at(ONE_LSHIFT_63 | seqNo_cx));
-            TSeq const & kmer_str = seqan::infixWithLength(seq, seqPos, k_max);
+    transform(io_cfg, primer_cfg, masks, seqNoMap, kmerIDs);
+}
 
-            // append encoded, longest k-mer for this position
-            kmerID |= dna_encoder(kmer_str);
+/*
+ * Streaming variant of the above consuming location groups from `queue` while the
+ * mapper is still producing them. Only the kept locations are stored, the
+ * location lists are released as soon as they are filtered.
+ */
+void filter_and_transform(io_cfg_type const & io_cfg, primer_cfg_type const & primer_cfg, TLocationQueue & queue, TSeqNoMap & seqNoMap, TKmerIDs & kmerIDs)
+{
+    TLengthMasks masks;
+    TLocationGroup group;
+    while (queue.pop(group))
+        filter_locations(primer_cfg, group.K, group.locations, masks);
 
-            // erase those length bits in prefix corresponding to kmers not passing the filter
-            chemical_filter_single_pass(kmerID);
+    transform(io_cfg, primer_cfg, masks, seqNoMap, kmerIDs);
+}
 
-            // do not store Kmer and reset bit in reference
-            if (!(PREFIX_SELECTOR & kmerID))
-                references[seqNo_cx][seqPos] = 0;
-            else
-                kmerIDs[seqNo_cx].push_front(kmerID);
-        }
+/*
+ * Run mapper and filter_and_transform as overlapping stages connected by a bounded
+ * queue of `queue_size` location groups. Peak memory is bounded by the queue size
+ * and the kept locations instead of the complete location map.
+ */
+void map_filter_and_transform(io_cfg_type const & io_cfg, primer_cfg_type const & primer_cfg, TSeqNoMap & seqNoMap, TKmerIDs & kmerIDs, size_t const queue_size = 1 << 12)
+{
+    TLocationQueue queue(queue_size);
+    std::future<int> mapped = std::async(std::launch::async, [&]()
+    {
+        return fm_map(io_cfg, primer_cfg, queue);
+    });
+    try
+    {
+        filter_and_transform(io_cfg, primer_cfg, queue, seqNoMap, kmerIDs);
     }
+    catch (...)
+    {
+        // unblock mapper, further groups are discarded
+        queue.close();
+        throw;
+    }
+    // rethrows exceptions of the mapper
+    mapped.get();
 }
 
+// Maximal number of forward kmers combined by one task of the parallel combiner.
+#define COMBINE_CHUNK_SIZE 1024
+
+/*
+ * A task of the parallel combiner, the forward kmers with ranks [r_begin, r_end)
+ * of reference seqNo_cx.
+ */
+struct TCombineTask
+{
+    uint64_t seqNo_cx;
+    uint64_t r_begin;
+    uint64_t r_end;
+};
+
 /* Combine based on suitable location distances s.t. transcript length is in permitted range.
  * Chemical suitability will be tested by a different function. First position indicates,
  * that the k-mer corresponds to a forward primer, and second position indicates reverse
- * primer, i.e. (k1, k2) != (k2, k1).
+ * primer, i.e. (k1, k2) != (k2, k1). Kernel for primer lengths TLengths, which
+ * may be the full range if the configured one has no instantiated kernel. Window
+ * bounds are taken from the configured lengths, length bits outside of them are ignored.
+ * References vary from short fragments to whole genomes, hence the forward kmers
+ * of each reference are split into tasks of COMBINE_CHUNK_SIZE kmers, which are
+ * handed out dynamically to `threads` threads. Each task collects pairs and counts
+ * in its own buffer, buffers are concatenated in task order to reproduce the
+ * result of the sequential run.
+ * Partner windows are read from the ascending kmer positions stored next to the
+ * kmerIDs. Window bounds grow with the forward position, hence both window pointers
+ * advance monotonically through a task and no rank or select queries are needed.
+ * Melting temperatures, CG clamp and tail tests are looked up in the attributes
+ * computed once per kmerID, length combinations of a pair are built row by row
+ * from the eligible lengths of both kmers. Cross-annealing is only tested for pairs
+ * sharing complementary 4-mers, which is checked with AVX2 if the CPU supports it.
  */
-template<typename TPairList>
-void combine(TReferences const & references, TKmerIDs const & kmerIDs, TPairList & pairs, TKmerCounts * kmerCounts = nullptr)
+template<typename TLengths, typename TPairList>
+void combine_kernel(primer_cfg_type const & primer_cfg, TKmerIDs const & kmerIDs, TPairList & pairs, TKmerCounts * kmerCounts, unsigned const threads)
 {
     pairs.clear();
-    auto cp_ctr = 0ULL;
-    for (uint64_t seqNo_cx = 0; seqNo_cx < references.size(); ++seqNo_cx)
+    uint64_t const transcript_min_len = primer_cfg.get_transcript_min_len();
+    uint64_t const transcript_max_len = primer_cfg.get_transcript_max_len();
+    // window bounds and length bits from the configured lengths, TLengths may be a superset of them
+    uint64_t const primer_min_len = primer_cfg.get_primer_min_len();
+    uint64_t const primer_max_len = primer_cfg.get_primer_max_len();
+    uint64_t const selector = TLengths::SELECTOR & (((ONE_LSHIFT_63 >> (primer_min_len - PRIMER_MIN_LEN)) << 1) - (ONE_LSHIFT_63 >> (primer_max_len - PRIMER_MIN_LEN)));
+    __m128i const dTm_max = _mm_set1_epi8(std::min<uint64_t>(primer_cfg.get_dTm(), 255));
+    static bool const avx2 = __builtin_cpu_supports("avx2");
+
+    // (i) kmer attributes independent of the pairing partner
+    std::vector<TKmerAttributes> attributes;
+    kmer_attributes(kmerIDs, attributes, threads);
+
+    // (ii) split forward kmers into tasks in the order of the sequential run
+    std::vector<TCombineTask> tasks;
+    for (uint64_t seqNo_cx = 0; seqNo_cx < kmerIDs.size(); ++seqNo_cx)
     {
-        sdsl::bit_vector reference;
-        sdsl::util::assign(reference, references.at(seqNo_cx));
-        sdsl::rank_support_v5<1, 1> r1s(&references.at(seqNo_cx));
-        sdsl::select_support_mcl<1> s1s(&reference);
+        uint64_t const r_end = kmerIDs.size(seqNo_cx);
+        for (uint64_t r_begin = 1; r_begin < r_end; r_begin += COMBINE_CHUNK_SIZE)
+            tasks.push_back(TCombineTask{seqNo_cx, r_begin, std::min<uint64_t>(r_begin + COMBINE_CHUNK_SIZE, r_end)});
+    }
 
-        for (uint64_t r_fwd = 1; r_fwd < r1s.rank(reference.size()); ++r_fwd)
+    // (iii) combine per task with a sliding window [i_begin, i_end) over the kmers
+    // of the reference
+    std::vector<TPairList> pairs_per_task(tasks.size());
+    std::vector<uint64_t> combinations_per_task(tasks.size(), 0);
+    parallel_for(tasks.size(), threads, [&](uint64_t const task, unsigned const)
+    {
+        auto const [seqNo_cx, r_begin, r_end] = tasks[task];
+        TKmerID const * const kmerIDs_reference = kmerIDs.data(seqNo_cx);
+        TSeqPos const * const positions = kmerIDs.positions_data(seqNo_cx);
+        TKmerAttributes const * const attributes_reference = attributes.data() + kmerIDs.offset(seqNo_cx);
+        uint64_t const n = kmerIDs.size(seqNo_cx);
+        TPairList & pairs_task = pairs_per_task[task];
+        uint64_t & combinations = combinations_per_task[task];
+
+        // windows start behind their forward kmer
+        uint64_t i_begin = r_begin;
+        uint64_t i_end = r_begin;
+        for (uint64_t r_fwd = r_begin; r_fwd < r_end; ++r_fwd)
         {
-            uint64_t idx_fwd = s1s.select(r_fwd);  // text position of r-th k-mer
-            TKmerID kmerID_fwd = kmerIDs[seqNo_cx][r_fwd - 1];
+            TSeqPos const idx_fwd = positions[r_fwd - 1];  // text position of r-th k-mer
+            TKmerID kmerID_fwd = kmerIDs_reference[r_fwd - 1];
+            TKmerAttributes const & attributes_fwd = attributes_reference[r_fwd - 1];
 
             // minimal window start position for pairing kmer
-            uint64_t w_begin = idx_fwd + PRIMER_MIN_LEN + TRANSCRIPT_MIN_LEN;
+            uint64_t const w_begin = idx_fwd + primer_min_len + transcript_min_len;
 
             // maximal window end position (exclusive) for pairing kmer
-            uint64_t w_end = std::min(reference.size(), idx_fwd + PRIMER_MAX_LEN + TRANSCRIPT_MAX_LEN + 1);
+            uint64_t const w_end = idx_fwd + primer_max_len + transcript_max_len + 1;
+
+            for (; i_begin < n && positions[i_begin] < w_begin; ++i_begin);
+            for (i_end = std::max(i_end, i_begin); i_end < n && positions[i_end] < w_end; ++i_end);
 
             // iterate through kmers in reference sequence window [w_begin : w_end]
             // note that w_begin/end are updated due to varying kmer length of same kmerID
-            for (uint64_t r_rev = r1s.rank(w_begin) + 1; r_rev <= r1s.rank(w_end); ++r_rev)
+            for (uint64_t i_rev = i_begin; i_rev < i_end; ++i_rev)
             {
+                uint64_t const r_rev = i_rev + 1;
                 TCombinePattern<TKmerID, TKmerLength> cp;
-                uint64_t mask_fwd = ONE_LSHIFT_63;
-                TKmerID kmerID_rev = kmerIDs.at(seqNo_cx).at(r_rev - 1);
-                filter_cross_annealing(kmerID_fwd, kmerID_rev);
-                while ((((mask_fwd - 1) << 1) & kmerID_fwd) >> 54)
+                TKmerID kmerID_rev = kmerIDs_reference[i_rev];
+                TKmerAttributes const & attributes_rev = attributes_reference[i_rev];
+                if (avx2 ? cross_annealing_candidate_avx2(attributes_fwd, attributes_rev) : cross_annealing_candidate(attributes_fwd, attributes_rev))
+                    filter_cross_annealing(kmerID_fwd, kmerID_rev);
+                // lengths of the forward primer not ending with TTT, ATT and passing the CG clamp
+                uint64_t const lanes_fwd = ((kmerID_fwd & selector) >> (WORD_SIZE - PREFIX_SIZE)) & attributes_fwd.fwd;
+                uint64_t const lanes_rev = ((kmerID_rev & selector) >> (WORD_SIZE - PREFIX_SIZE)) & attributes_rev.rev;
+                if (lanes_rev)
                 {
-                    // check forward primer not ending with TTT, ATT
-                    if ((mask_fwd & kmerID_fwd) && filter_CG_clamp(kmerID_fwd, '+', mask_fwd) && filter_WWW_tail(kmerID_fwd, '+', mask_fwd))
+                    for (uint64_t lanes = lanes_fwd; lanes; lanes &= lanes - 1)
                     {
-                        uint64_t mask_rev = ONE_LSHIFT_63;
-                        while ((((mask_rev - 1) << 1) & kmerID_rev) >> 54)
-                        {
-                            cp_ctr++;
-                            if (mask_rev & kmerID_rev && filter_CG_clamp(kmerID_rev, '-') && filter_WWW_tail(kmerID_rev, '-'))
-                            {
-                                if (dTm(kmerID_fwd, mask_fwd, kmerID_rev, mask_rev) <= PRIMER_DTM)
-                                {
-                                    {
-                                        // store combination bit
-                                        cp.set(mask_fwd, mask_rev);
-                                        if (kmerCounts)
-                                            ++kmerCounts->at(KMER_COUNTS::COMBINER_CNT);
-                                    }
-                                }
-                            }
-                            mask_rev >>= 1; // does not affect search window, since starting position is fixed
-                        } // length mask_rev
+                        uint64_t const lane_fwd = __builtin_ctzll(lanes);
+                        uint64_t row = lanes_rev & Tm_partners(attributes_fwd, lane_fwd, attributes_rev, dTm_max);
+                        combinations += __builtin_popcountll(row);
+                        // store combination bits
+                        for (; row; row &= row - 1)
+                            cp.set(1ULL << (WORD_SIZE - PREFIX_SIZE + lane_fwd), 1ULL << (WORD_SIZE - PREFIX_SIZE + __builtin_ctzll(row)));
                     }
-                    mask_fwd >>= 1;
-                } // length mask_fwd
+                }
                 if (cp.is_set())
                 {
-                    pairs.push_back(TPair<TCombinePattern<TKmerID, TKmerLength>>{seqNo_cx, r_fwd, r_rev, cp});
+                    pairs_task.push_back(TPair<TCombinePattern<TKmerID, TKmerLength>>{seqNo_cx, r_fwd, r_rev, cp});
                 }
             } // kmerID rev
         } // kmerID fwd
+    });
+
+    // (iv) concatenate task buffers in task order
+    uint64_t num_pairs{0};
+    for (TPairList const & pairs_task : pairs_per_task)
+        num_pairs += pairs_task.size();
+    pairs.reserve(num_pairs);
+    for (uint64_t task = 0; task < tasks.size(); ++task)
+    {
+        pairs.insert(pairs.end(), std::make_move_iterator(pairs_per_task[task].begin()), std::make_move_iterator(pairs_per_task[task].end()));
+        TPairList().swap(pairs_per_task[task]);
+        if (kmerCounts)
+            kmerCounts->at(KMER_COUNTS::COMBINER_CNT) += combinations_per_task[task];
     }
 }
 
+// Combine with the kernel for the primer length range of primer_cfg on `threads` threads.
+template<typename TPairList>
+void combine(primer_cfg_type const & primer_cfg, TKmerIDs const & kmerIDs, TPairList & pairs, TKmerCounts * kmerCounts = nullptr, unsigned const threads = 1)
+{
+    primer_length_apply(primer_cfg, [&](auto lengths)
+    {
+        combine_kernel<decltype(lengths)>(primer_cfg, kmerIDs, pairs, kmerCounts, threads);
+    });
+}
+
 // Apply frequency cutoff for unique pair occurences
 template<typename TPairList, typename TPairFreqList>
-void filter_pairs(io_cfg_type const & io_cfg, TReferences & references, TKmerIDs const & kmerIDs, TPairList & pairs, TPairFreqList & pair_freqs, TKmerCounts * kmerCounts = nullptr)
+void filter_pairs(io_cfg_type const & io_cfg, TKmerIDs const & kmerIDs, TPairList & pairs, TPairFreqList & pair_freqs, TKmerCounts * kmerCounts = nullptr)
 {
     unsigned const freq_pair_min = io_cfg.get_freq_pair_min();
     std::unordered_map<uint64_t, uint32_t> pairhash2freq;
@@ -277,8 +427,8 @@ void filter_pairs(io_cfg_type const & io_cfg, TReferences & references, TKmerIDs
     {
         std::vector<std::pair<uint8_t, uint8_t>> combinations;
         it_pairs->cp.get_combinations(combinations);
-        TKmerID kmerID_fwd = kmerIDs.at(it_pairs->reference).at(it_pairs->r_fwd - 1);
-        TKmerID kmerID_rev = kmerIDs.at(it_pairs->reference).at(it_pairs->r_rev - 1);
+        TKmerID kmerID_fwd = kmerIDs.at(it_pairs->reference, it_pairs->r_fwd - 1);
+        TKmerID kmerID_rev = kmerIDs.at(it_pairs->reference, it_pairs->r_rev - 1);
 
         for (auto comb : combinations)
         {
@@ -292,13 +442,13 @@ void filter_pairs(io_cfg_type const & io_cfg, TReferences & references, TKmerIDs
         }
     }
 
-    // Reset bits of kmer prefixes if and in references if prefix is finally empty
+    // Reset combination bits of pairs below the frequency cutoff
     uint64_t ctr_reset = 0;
     std::unordered_set<uint64_t> seen;
     for (auto it_pairs = pairs.begin(); it_pairs != pairs.end(); ++it_pairs)
     {
-        TKmerID kmer_fwd = kmerIDs.at(it_pairs->reference).at(it_pairs->r_fwd - 1);
-        TKmerID kmer_rev = kmerIDs.at(it_pairs->reference).at(it_pairs->r_rev - 1);
+        TKmerID kmer_fwd = kmerIDs.at(it_pairs->reference, it_pairs->r_fwd - 1);
+        TKmerID kmer_rev = kmerIDs.at(it_pairs->reference, it_pairs->r_rev - 1);
         std::vector<std::pair<uint8_t, uint8_t>> combinations;
         it_pairs->cp.get_combinations(combinations);
         for (auto comb : combinations)
@@ -7,10 +7,14 @@
 #pragma once
 
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
+#include <future>
 #include <iostream>
 #include <map>
+#include <stdexcept>
+#include <string>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -18,9 +22,18 @@
 
 #include <type_traits>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 // TODO: place proper seqan version
 #define SEQAN_APP_VERSION "1.0.0"
 
+// Mismatches from which on approximate matches are found by search schemes, i.e.
+// schemes are used for all E in [1:3]. Compare with neighbour extension along the
+// traversal with tests/search_scheme_benchmark.cpp before raising it.
+#define SEARCH_SCHEME_MIN_ERRORS 1
+
 //#include <seqan/arg_parse.h>
 #include <seqan/basic.h>
 #include <seqan/seq_io.h>
@@ -42,58 +55,661 @@
 
 #pragma GCC diagnostic pop
 
+#include "errors.hpp"
 #include "io_cfg_type.hpp"
+#include "kmer_counter.hpp"
+#include "location_store.hpp"
+#include "parallel.hpp"
 #include "primer_cfg_type.hpp"
+#include "search_schemes.hpp"
 #include "types.hpp"
 #include "utilities.hpp"
 
 namespace priset
 {
+// Print duration of an indexing phase since `start` and reset `start`.
+inline void fm_index_phase(std::string const & phase, std::chrono::time_point<std::chrono::steady_clock> & start)
+{
+    auto const finish = std::chrono::steady_clock::now();
+    std::cout << "INFO: index phase " << phase << " took " << std::chrono::duration_cast<std::chrono::milliseconds>(finish - start).count() << " ms" << std::endl;
+    start = finish;
+}
+
+// Type tag to pass a type to generic lambdas.
+template<typename T>
+struct TTypeTag
+{
+    using Type = T;
+};
+
+// FM index flavour given at run time, see TFMIndexConfigFlavour.
+struct TFMFlavour
+{
+    // BWT length width in bits, 32 or 64
+    unsigned bwt_width;
+    // suffix array sampling rate
+    unsigned sampling;
+};
+
 /*
- * Create FM index with `genmap` binary and store in io_cfg.genmap_idx_dir
+ * Call f(TTypeTag<TConfig>{}) with the FM index configuration TConfig of flavour.
+ * Templates are instantiated for BWT widths of 32 and 64 bit and sampling rates of
+ * 5, 10 (default), 20 and 40, other flavours throw std::invalid_argument.
+ */
+template<typename TFunc>
+void fm_flavour_apply(TFMFlavour const & flavour, TFunc && f)
+{
+    auto apply_sampling = [&](auto bwt_tag)
+    {
+        using TLengthSum = typename decltype(bwt_tag)::Type;
+        switch (flavour.sampling)
+        {
+            case 5: f(TTypeTag<TFMIndexConfigFlavour<TLengthSum, 5> >{}); break;
+            case 10: f(TTypeTag<TFMIndexConfigFlavour<TLengthSum, 10> >{}); break;
+            case 20: f(TTypeTag<TFMIndexConfigFlavour<TLengthSum, 20> >{}); break;
+            case 40: f(TTypeTag<TFMIndexConfigFlavour<TLengthSum, 40> >{}); break;
+            default: throw std::invalid_argument("ERROR: unsupported suffix array sampling rate " + std::to_string(flavour.sampling));
+        }
+    };
+    if (flavour.bwt_width == 32)
+        apply_sampling(TTypeTag<uint32_t>{});
+    else if (flavour.bwt_width == 64)
+        apply_sampling(TTypeTag<uint64_t>{});
+    else
+        throw std::invalid_argument("ERROR: unsupported BWT width " + std::to_string(flavour.bwt_width));
+}
+
+/*
+ * Read the flavour of the FM index stored in io_cfg.get_index_dir() from its
+ * index.info entries bwt_dimensions and sampling_rate.
+ */
+TFMFlavour fm_flavour_load(io_cfg_type const & io_cfg)
+{
+    TDirectoryInformation info;
+    if (!seqan::open(info, io_cfg.get_index_info_path().string().c_str(), seqan::OPEN_RDONLY))
+        throw std::runtime_error("ERROR: could not open " + io_cfg.get_index_info_path().string());
+    TFMFlavour flavour{0, 0};
+    for (uint64_t i = 0; i < seqan::length(info); ++i)
+    {
+        std::string const entry = seqan::toCString(seqan::CharString(info[i]));
+        std::string const key = entry.substr(0, entry.find(':'));
+        unsigned const value = std::atoi(entry.substr(entry.find(':') + 1).c_str());
+        if (key == "bwt_dimensions")
+            flavour.bwt_width = value;
+        else if (key == "sampling_rate")
+            flavour.sampling = value;
+    }
+    return flavour;
+}
+
+/*
+ * Build the FM index of flavour TConfig for text and store its fibres.
+ * TConfig      FM index configuration, see TFMIndexConfigFlavour
+ */
+template<typename TConfig>
+bool fm_index_build(io_cfg_type const & io_cfg, TStringSet & text, std::chrono::time_point<std::chrono::steady_clock> & start)
+{
+    TIndexOf<TConfig> index(text);
+    std::cout << "STATUS: create forward index" << std::endl;
+    seqan::indexCreateProgress(index.fwd, seqan::FibreSALF());
+    fm_index_phase("SA_LF_FWD", start);
+    std::cout << "STATUS: create reverse index" << std::endl;
+    seqan::indexCreateProgress(index.rev, seqan::FibreSALF());
+    fm_index_phase("SA_LF_REV", start);
+    return seqan::save(index, io_cfg.get_index_base_path().string().c_str());
+}
+
+/*
+ * Create bidirectional FM index in-process and store it in io_cfg.get_index_dir().
+ * The suffix arrays are built with lambda's suffix array construction, which
+ * prints its progress and runs on io_cfg.get_threads() OpenMP threads. Besides the
+ * index fibres, the text corpus (index.txt), the sequence directory (index.ids)
+ * and the index flavour (index.info) are written in the same layout genmap uses.
+ * The flavour is taken from io_cfg, without a BWT width the 32 bit flavour is
+ * chosen if the text including sentinels is shorter than 2^32.
  */
 int fm_index(io_cfg_type const & io_cfg)
 {
     std::cout << "MESSAGE: start index recomputation" << std::endl;
-    std::string cmd = io_cfg.get_genmap_binary().string() + " index -F " + io_cfg.get_fasta_file().string() + " -I " + io_cfg.get_index_dir().string();
-    std::system(cmd.c_str());
+    auto start = std::chrono::steady_clock::now();
+#ifdef _OPENMP
+    omp_set_num_threads(io_cfg.get_threads());
+#endif
+
+    // (i) parse library, sequence directory entries are <fasta_file>;<length>;<header>
+    seqan::SeqFileIn seq_file;
+    if (!seqan::open(seq_file, io_cfg.get_fasta_file().string().c_str()))
+    {
+        std::cerr << "ERROR: could not open fasta file " << io_cfg.get_fasta_file() << std::endl;
+        return SRC_READ_ERROR;
+    }
+    TStringSet text;
+    TDirectoryInformation directory;
+    seqan::CharString id;
+    TString seq;
+    std::string const fasta_name = io_cfg.get_fasta_file().filename().string();
+    while (!seqan::atEnd(seq_file))
+    {
+        seqan::readRecord(id, seq, seq_file);
+        seqan::appendValue(text, seq);
+        std::string const entry = fasta_name + ";" + std::to_string(seqan::length(seq)) + ";" + seqan::toCString(id);
+        seqan::appendValue(directory, seqan::CharString(entry.c_str()));
+    }
+    if (!seqan::lengthSum(text))
+    {
+        std::cerr << "ERROR: no sequences in " << io_cfg.get_fasta_file() << std::endl;
+        return SRC_READ_ERROR;
+    }
+    fm_index_phase("PARSE", start);
+
+    bool const fits_32 = seqan::lengthSum(text) + seqan::length(text) < (1ULL << 32);
+    TFMFlavour const flavour{io_cfg.get_index_bwt_width() ? io_cfg.get_index_bwt_width() : (fits_32 ? 32U : 64U),
+                             io_cfg.get_index_sampling() ? io_cfg.get_index_sampling() : TFMIndexConfig::SAMPLING};
+    if (flavour.bwt_width == 32 && !fits_32)
+    {
+        std::cerr << "ERROR: text of " << seqan::lengthSum(text) << " bp does not fit a 32 bit BWT" << std::endl;
+        return IDX_FLAVOUR_ERROR;
+    }
+    std::cout << "INFO: FM index flavour with " << flavour.bwt_width << " bit BWT and SA sampling rate " << flavour.sampling << std::endl;
+
+    fs::create_directories(io_cfg.get_index_dir());
+    // write text, directory and flavour while the suffix arrays are built
+    std::future<bool> text_saved = std::async(std::launch::async, [&]()
+    {
+        TDirectoryInformation info;
+        for (std::string const entry : {"alphabet_size:" + std::to_string(seqan::ValueSize<seqan::Dna>::VALUE),
+                                        "sa_dimensions_i1:" + std::to_string(sizeof(TSeqNo) << 3),
+                                        "sa_dimensions_i2:" + std::to_string(sizeof(TSeqPos) << 3),
+                                        "bwt_dimensions:" + std::to_string(flavour.bwt_width),
+                                        "sampling_rate:" + std::to_string(flavour.sampling),
+                                        std::string{"fasta_directory:false"}})
+            seqan::appendValue(info, seqan::CharString(entry.c_str()));
+        return seqan::save(text, io_cfg.get_index_txt_path().string().c_str()) &&
+               seqan::save(directory, io_cfg.get_index_base_path_ids().string().c_str()) &&
+               seqan::save(info, io_cfg.get_index_info_path().string().c_str());
+    });
+
+    // (ii) suffix arrays and BWTs of forward and reversed text, (iii) store index fibres
+    bool index_saved{0};
+    try
+    {
+        fm_flavour_apply(flavour, [&](auto config_tag)
+        {
+            index_saved = fm_index_build<typename decltype(config_tag)::Type>(io_cfg, text, start);
+        });
+    }
+    catch (std::invalid_argument const & e)
+    {
+        text_saved.wait();
+        std::cerr << e.what() << std::endl;
+        return IDX_FLAVOUR_ERROR;
+    }
+    if (!text_saved.get() || !index_saved)
+    {
+        std::cerr << "ERROR: could not write index to " << io_cfg.get_index_dir() << std::endl;
+        return IDX_WRITE_ERROR;
+    }
+    fm_index_phase("SAVE", start);
     return 0;
 }
 
 /*
- * Map frequent k-mers to exisiting FM index with `genmap` without file IO
+ * Load the bidirectional FM index stored in io_cfg.get_index_dir(). With TIndexMMap
+ * the fibres are mapped read-only into memory and pages are shared via the page
+ * cache with other processes working on the same index. The flavour recorded in
+ * index.info has to match the one of TIndex, see fm_flavour_apply for dispatching.
+ * TIndex        bidirectional FM index type, see types.hpp
+ */
+template<typename TIndex>
+void fm_load(io_cfg_type const & io_cfg, TIndex & index)
+{
+    using TConfig = typename TFMIndexConfigOf<TIndex>::Type;
+    TFMFlavour const flavour = fm_flavour_load(io_cfg);
+    if (flavour.bwt_width != (sizeof(typename TConfig::LengthSum) << 3) || flavour.sampling != TConfig::SAMPLING)
+        throw std::runtime_error("ERROR: FM index flavour (" + std::to_string(flavour.bwt_width) + " bit BWT, sampling rate " +
+                                 std::to_string(flavour.sampling) + ") does not match index type");
+    std::string const index_path = io_cfg.get_index_base_path().string();
+    if (!seqan::open(index, index_path.c_str(), seqan::OPEN_RDONLY))
+        throw std::runtime_error("ERROR: could not open FM index " + index_path);
+}
+
+/*
+ * Load text corpus stored in io_cfg.get_index_txt_path() (index.txt.concat and
+ * index.txt.limits). With TStringSetMMap the concatenation is mapped read-only
+ * into memory instead of being copied.
+ */
+template<typename TText>
+void text_load(io_cfg_type const & io_cfg, TText & text)
+{
+    fs::path text_path = io_cfg.get_index_txt_path();
+    seqan::open(text, text_path.string().c_str(), seqan::OPEN_RDONLY);
+    if (!seqan::lengthSum(text))
+        throw std::length_error("Reference text size is 0!");
+}
+
+/*
+ * Load text corpus, memory-mapped if io_cfg.get_mmap() is set, and pass it to f.
+ */
+template<typename TFunc>
+void text_apply(io_cfg_type const & io_cfg, TFunc && f)
+{
+    if (io_cfg.get_mmap())
+    {
+        TStringSetMMap text;
+        text_load(io_cfg, text);
+        f(text);
+    }
+    else
+    {
+        TStringSet text;
+        text_load(io_cfg, text);
+        f(text);
+    }
+}
+
+// Set of index iterators reached by the current k-mer prefix together with the
+// number of mismatches spent on them. The first entry is always the exact match.
+template<typename TIter>
+using TMatchSet = std::vector<std::pair<TIter, uint8_t>>;
+
+// Collect (approximate) occurrences of all matches in lexicographical order.
+template<typename TIter>
+void fm_map_occurrences(TMatchSet<TIter> const & matches, std::vector<TLocation> & occs)
+{
+    occs.clear();
+    for (auto const & [it, errors] : matches)
+    {
+        auto const & occs_it = seqan::getOccurrences(it, seqan::Fwd());
+        for (uint64_t i = 0; i < seqan::length(occs_it); ++i)
+            occs.push_back(TLocation{seqan::getValueI1(occs_it[i]), seqan::getValueI2(occs_it[i])});
+    }
+    std::sort(occs.begin(), occs.end());
+}
+
+/*
+ * Report all occurrences of a frequent k-mer of length K as one record, keyed by
+ * the leftmost exact occurrence.
+ */
+template<typename TIter>
+void fm_map_report(TMatchSet<TIter> const & matches, TKmerLength const K, TKLocations & locations)
+{
+    std::vector<TLocation> occs;
+    fm_map_occurrences(matches, occs);
+    // the first match is the exact one
+    auto const & occs_exact = seqan::getOccurrences(matches.front().first, seqan::Fwd());
+    TLocation key{seqan::getValueI1(occs_exact[0]), seqan::getValueI2(occs_exact[0])};
+    for (uint64_t i = 1; i < seqan::length(occs_exact); ++i)
+        key = std::min(key, TLocation{seqan::getValueI1(occs_exact[i]), seqan::getValueI2(occs_exact[i])});
+    locations.append(K, key, occs);
+}
+
+// Push all occurrences of a frequent k-mer of length K as one group into the queue.
+template<typename TIter>
+void fm_map_report(TMatchSet<TIter> const & matches, TKmerLength const K, TLocationQueue & queue)
+{
+    TLocationGroup group{K, {}};
+    fm_map_occurrences(matches, group.locations);
+    queue.push(std::move(group));
+}
+
+// Extend iterator by character c to the right or, if left is set, to the left.
+template<typename TIter>
+bool fm_go_down(TIter & it, char const c, bool const left)
+{
+    return left ? seqan::goDown(it, seqan::Dna(c), seqan::Fwd()) : seqan::goDown(it, seqan::Dna(c), seqan::Rev());
+}
+
+/*
+ * Extend all matches of a k-mer prefix by character c. Returns false if the
+ * extended k-mer does not occur exactly, otherwise matches_next holds the exact
+ * match in front followed by all approximate ones with at most E mismatches and
+ * count is the total number of occurrences. With left set the k-mer is extended
+ * by a prepended character.
+ */
+template<typename TIter>
+bool fm_map_step(TMatchSet<TIter> const & matches, char const c, uint8_t const E, bool const left, TMatchSet<TIter> & matches_next, uint64_t & count)
+{
+    // the k-mer itself has to occur in the text
+    TIter it_exact = matches.front().first;
+    if (!fm_go_down(it_exact, c, left))
+        return false;
+    matches_next = TMatchSet<TIter>{{it_exact, 0}};
+    count = seqan::countOccurrences(it_exact);
+    for (auto const & [it, errors] : matches)
+    {
+        for (char const c2 : {'A', 'C', 'G', 'T'})
+        {
+            // exact extensions of approximate matches keep their error count
+            if (c2 == c && !errors)
+                continue;
+            uint8_t const errors_next = errors + (c2 != c);
+            if (errors_next > E)
+                continue;
+            TIter it_next = it;
+            if (fm_go_down(it_next, c2, left))
+            {
+                count += seqan::countOccurrences(it_next);
+                matches_next.push_back({it_next, errors_next});
+            }
+        }
+    }
+    return true;
+}
+
+/*
+ * Parameters of the k-mer traversal shared by all recursion levels.
+ * root             root iterator of the bidirectional FM index
+ * E                maximal number of mismatches (Hamming distance)
+ * freq_kmer_min    minimal number of occurrences for a k-mer to be reported
+ * min_len          minimal k-mer length, primer_cfg.get_primer_min_len()
+ * max_len          maximal k-mer length, primer_cfg.get_primer_max_len()
+ * steps            search scheme for E unrolled for min_len, empty if
+ *                  approximate matches are extended along the traversal
+ * anchor           number of 3' bases matching exactly, if set k-mers are
+ *                  extended to the left starting at their 3' end. Only the right
+ *                  end is anchored, which is the 3' end of forward primers, k-mers
+ *                  used as reverse primers may have mismatches at their 3' end.
+ */
+template<typename TIter>
+struct TMapParams
+{
+    TIter root;
+    uint8_t E;
+    unsigned freq_kmer_min;
+    uint64_t min_len;
+    uint64_t max_len;
+    std::vector<TSearchSteps> steps;
+    uint8_t anchor{0};
+};
+
+/*
+ * Number of mismatches permitted when extending a k-mer of length K by one base.
+ * With a search scheme approximate matches are searched at min_len and only
+ * the exact match is followed before. With a 3' anchor the first `anchor` bases of
+ * the leftwards traversal are matched exactly, i.e. the mapping is the two-part
+ * search scheme {exact 3' part, at most E mismatches in the 5' part}, which
+ * discards all approximate matches with 3' mismatches before they are extended.
+ */
+template<typename TIter>
+uint8_t fm_map_errors(TMapParams<TIter> const & params, TKmerLength const K)
+{
+    if (!params.steps.empty())
+        return (K >= params.min_len) ? params.E : 0;
+    return (K >= params.anchor) ? params.E : 0;
+}
+
+/*
+ * Replace the approximate matches of a k-mer of length params.min_len by those
+ * found with the search scheme in params.steps and update their total count.
+ */
+template<typename TIter>
+void fm_map_search(std::string const & kmer, TMapParams<TIter> const & params, TMatchSet<TIter> & matches, uint64_t & count)
+{
+    matches.resize(1);
+    count = seqan::countOccurrences(matches.front().first);
+    search_scheme(params.root, kmer, params.steps, [&](TIter const & it, uint8_t const errors)
+    {
+        // the exact match is already in front
+        if (!errors)
+            return;
+        count += seqan::countOccurrences(it);
+        matches.push_back({it, errors});
+    });
+}
+
+/*
+ * Depth-first traversal of the k-mers in the index. The k-mer prefix is extended
+ * by one character to the right, or to the left for 3'-anchored mapping, which
+ * turns `kmer` into the reversed k-mer. All k-mers of length K in
+ * [params.min_len, params.max_len] are reported within the same traversal, since
+ * a k-mer of length K + 1 shares the prefix interval of its K-prefix. If a search
+ * scheme is given, only the exact match is followed up to min_len, where the
+ * approximate matches are searched once and then extended for all larger K.
+ * matches          exact and approximate matches of current prefix
+ * K                current prefix length
+ * kmer             current prefix
+ * params           traversal parameters
+ * out              location map or queue the k-mer occurrences are reported to
+ */
+template<typename TIter, typename TOut>
+void fm_map_extend(TMatchSet<TIter> const & matches, TKmerLength const K, std::string & kmer, TMapParams<TIter> const & params, TOut & out)
+{
+    TMatchSet<TIter> matches_next;
+    uint64_t count;
+    uint8_t const E = fm_map_errors(params, K);
+    for (char const c : {'A', 'C', 'G', 'T'})
+    {
+        if (!fm_map_step(matches, c, E, params.anchor > 0, matches_next, count))
+            continue;
+        kmer.push_back(c);
+        if (!params.steps.empty() && K + 1ULL == params.min_len)
+            fm_map_search(kmer, params, matches_next, count);
+        // The occurrence count of a k-mer and its approximate matches does not increase
+        // with K, infrequent k-mers are pruned together with their subtree. With a
+        // search scheme approximate matches are known from min_len on.
+        bool const counted = params.steps.empty() || K + 1ULL >= params.min_len;
+        if (!counted || count >= params.freq_kmer_min)
+        {
+            if (K + 1ULL >= params.min_len)
+                fm_map_report(matches_next, K + 1, out);
+            if (K + 1ULL < params.max_len)
+                fm_map_extend(matches_next, K + 1, kmer, params, out);
+        }
+        kmer.pop_back();
+    }
+}
+
+/*
+ * Split the traversal into independent subtrees rooted at the prefixes of length
+ * `depth` < params.min_len. Each shard covers all K, since the k-mers of all lengths
+ * sharing a prefix are found in the same subtree. The prefix of shard i is kmers[i].
+ * Prefixes occurring less than freq_kmer_min times are pruned, with search schemes
+ * approximate matches are unknown at that depth and nothing is pruned.
+ */
+template<typename TIter>
+void fm_map_shards(TMatchSet<TIter> const & root, uint8_t const depth, TMapParams<TIter> const & params, std::vector<TMatchSet<TIter>> & shards, std::vector<std::string> & kmers)
+{
+    unsigned const freq_kmer_min = params.steps.empty() ? params.freq_kmer_min : 0;
+    shards = {root};
+    kmers = {std::string{}};
+    std::vector<TMatchSet<TIter>> shards_next;
+    std::vector<std::string> kmers_next;
+    TMatchSet<TIter> matches_next;
+    uint64_t count;
+    for (uint8_t d = 0; d < depth; ++d)
+    {
+        shards_next.clear();
+        kmers_next.clear();
+        uint8_t const E = fm_map_errors(params, d);
+        for (uint64_t i = 0; i < shards.size(); ++i)
+        {
+            for (char const c : {'A', 'C', 'G', 'T'})
+            {
+                if (fm_map_step(shards[i], c, E, params.anchor > 0, matches_next, count) && count >= freq_kmer_min)
+                {
+                    shards_next.push_back(matches_next);
+                    kmers_next.push_back(kmers[i] + c);
+                }
+            }
+        }
+        std::swap(shards, shards_next);
+        std::swap(kmers, kmers_next);
+    }
+}
+
+// True if k-mers are counted on the text corpus and no FM index is loaded.
+inline bool fm_map_counting(io_cfg_type const & io_cfg, primer_cfg_type const & primer_cfg)
+{
+    return io_cfg.get_kmer_counting() && !primer_cfg.get_error();
+}
+
+/*
+ * Map frequent k-mers of all lengths in [primer_cfg.get_primer_min_len(),
+ * primer_cfg.get_primer_max_len()] to the existing FM index in a single traversal. With io_cfg.get_threads() > 1 the
+ * traversal is sharded by k-mer prefixes and the shards are processed in parallel.
+ * For E in [SEARCH_SCHEME_MIN_ERRORS:3] approximate matches are found with optimum
+ * search schemes (see search_schemes.hpp). If primer_cfg.get_anchor() is set, the
+ * last bases of a k-mer, the 3' end as forward primer, have to match exactly and
+ * schemes are not used. For E = 0 and io_cfg.get_kmer_counting()
+ * set, the k-mers are counted by sorting the positions of the text corpus instead (see
+ * kmer_counter.hpp) and the FM index is not loaded.
+ * TFMIndex                 FM index type, TIndex or memory-mapped TIndexMMap
  * io_cfg_type              I/O configurator type
  * primer_cfg_type          primer configurator type
- * TLocations               type for storing locations
- * TDirectoryInformation    directory information type
+ * init                     callable receiving the number of sequences of the loaded
+ *                          text before the first output
+ * out                      callable returning the output of a thread given its id
  */
-int fm_map(io_cfg_type const & io_cfg, primer_cfg_type const & primer_cfg, TKLocations & locations)
+template<typename TFMIndex, typename TInit, typename TOutOfThread>
+void fm_map_traverse(io_cfg_type const & io_cfg, primer_cfg_type const & primer_cfg, TInit && init, TOutOfThread && out)
 {
-    std::string const s1 = io_cfg.get_index_dir().string();
-    std::string const s2 = io_cfg.get_mapping_dir().string();
-    locations.clear();
-    TLocations loc_per_K;
-    using TKLocationsKey = typename TKLocations::key_type;
-    using TKLocationsValue = typename TKLocations::mapped_type;
-    for (auto K = PRIMER_MIN_LEN; K <= PRIMER_MAX_LEN; ++K)
-    {
-        // if (K == 22) continue;
-        std::cout << "STATUS: run genmap::mappability with E = " << primer_cfg.get_error() << std::endl;
-        std::cout << "INFO: K = " << K << std::endl;
-        // Remark: csv flag triggers `csvComputation` and therefore the population of the (TLocations) locations vector!
-        char const * argv[11] = {"map", "-I", s1.c_str(), "-O", s2.c_str(), "-K", std::to_string(K).c_str(), "-E", std::to_string(primer_cfg.get_error()).c_str(), "--csvRAM", "-fl"};
-        unsigned const freq_kmer_min = io_cfg.get_freq_kmer_min();
-        mappabilityMain<TLocations>(11, argv, loc_per_K, freq_kmer_min);
-        TKLocations::iterator it_hint = locations.begin();
-        // inserting map pair using hint
-        for (auto it = loc_per_K.begin(); it != loc_per_K.end(); ++it)
-        {  // it is pair(key, value) with key = TLocation, value = std::pair<std::vector<TLocations>, std::vector<TLocations>>
-            TKLocation const key = std::make_tuple(seqan::getValueI1<TSeqNo, TSeqPos>(it->first), seqan::getValueI2<TSeqNo, TSeqPos>(it->first), K);
-            TKLocationsValue const value = it->second;
-            it_hint = locations.insert(it_hint, std::pair<TKLocationsKey, TKLocationsValue>(key, value));
+    if (io_cfg.get_kmer_counting())
+    {
+        if (fm_map_counting(io_cfg, primer_cfg))
+        {
+            std::cout << "STATUS: count k-mers by sorting with " << io_cfg.get_threads() << " thread(s)" << std::endl;
+            text_apply(io_cfg, [&](auto const & text)
+            {
+                init(seqan::length(text));
+                kmer_count_traverse(text, primer_cfg.get_primer_min_len(), primer_cfg.get_primer_max_len(), io_cfg.get_freq_kmer_min(), io_cfg.get_threads(), out);
+            });
+            return;
         }
+        std::cout << "INFO: k-mer counting supports only E = 0, fall back to FM index mapping" << std::endl;
+    }
+    using TIter = seqan::Iter<TFMIndex, seqan::VSTree<seqan::TopDown<>>>;
+    TFMIndex index;
+    fm_load(io_cfg, index);
+    init(seqan::length(seqan::indexText(index)));
+    unsigned const threads = io_cfg.get_threads();
+    uint8_t const E = primer_cfg.get_error();
+    TMapParams<TIter> params{TIter(index), E, io_cfg.get_freq_kmer_min(), primer_cfg.get_primer_min_len(), primer_cfg.get_primer_max_len(), {}};
+    if (E && primer_cfg.get_anchor())
+        params.anchor = std::min<uint64_t>(primer_cfg.get_anchor(), params.max_len);
+    else if (E >= SEARCH_SCHEME_MIN_ERRORS)
+        params.steps = search_scheme_steps(search_scheme(E), params.min_len);
+    std::cout << "STATUS: run single traversal mapping with E = " << int(E) << " and " << threads << " thread(s)" << (params.steps.empty() ? "" : " using search schemes") << std::endl;
+    if (params.anchor)
+        std::cout << "INFO: last " << int(params.anchor) << " bases at 3' end of forward primers match exactly" << std::endl;
+    std::cout << "INFO: K in [" << params.min_len << ":" << params.max_len << "]" << std::endl;
+    TMatchSet<TIter> root{{params.root, 0}};
+    std::string kmer;
+    kmer.reserve(params.max_len);
+    if (threads == 1)
+    {
+        fm_map_extend(root, 0, kmer, params, out(0));
+        return;
+    }
+
+    // about 16 shards per thread to balance the uneven subtree sizes
+    uint8_t depth = 2;
+    while ((1ULL << (depth << 1)) < 16ULL * threads && depth + 1ULL < params.min_len)
+        ++depth;
+    std::vector<TMatchSet<TIter>> shards;
+    std::vector<std::string> kmers;
+    fm_map_shards(root, depth, params, shards, kmers);
+    parallel_for(shards.size(), threads, [&](uint64_t const i, unsigned const thread_id)
+    {
+        fm_map_extend(shards[i], depth, kmers[i], params, out(thread_id));
+    });
+}
+
+/*
+ * Map frequent k-mers and collect them in `locations`. Each thread collects its
+ * shards in a thread-local location store, the stores are concatenated and the
+ * keys radix sorted afterwards. Locations are packed with a bit width sized from
+ * the number of sequences of the loaded text.
+ * TKLocations              type for storing locations augmented by K
+ */
+template<typename TFMIndex>
+int fm_map(io_cfg_type const & io_cfg, primer_cfg_type const & primer_cfg, TKLocations & locations)
+{
+    std::vector<TKLocations> locations_per_thread;
+    fm_map_traverse<TFMIndex>(io_cfg, primer_cfg, [&](uint64_t const num_seqs)
+    {
+        locations.reset(num_seqs);
+        locations_per_thread.assign(io_cfg.get_threads(), locations);
+    }, [&](unsigned const thread_id) -> TKLocations &
+    {
+        return locations_per_thread[thread_id];
+    });
+    for (auto & locations_thread : locations_per_thread)
+        locations.merge(locations_thread);
+    locations.sort();
+    return 0;
+}
+
+/*
+ * Map frequent k-mers and push each k-mer's locations as one group into `queue`,
+ * which is closed when the traversal is done or failed. Used as producer stage
+ * concurrently to the consuming filter_and_transform, the locations are never
+ * materialized completely.
+ */
+template<typename TFMIndex>
+int fm_map(io_cfg_type const & io_cfg, primer_cfg_type const & primer_cfg, TLocationQueue & queue)
+{
+    try
+    {
+        // groups hold unpacked locations
+        fm_map_traverse<TFMIndex>(io_cfg, primer_cfg, [](uint64_t const){}, [&](unsigned const) -> TLocationQueue &
+        {
+            return queue;
+        });
+    }
+    catch (...)
+    {
+        queue.close();
+        throw;
     }
+    queue.close();
     return 0;
 }
 
+/*
+ * Map k-mers with FM index read into heap memory or memory-mapped if io_cfg.get_mmap()
+ * is set. The index type is chosen by the flavour recorded in index.info. For k-mer
+ * counting neither index nor index.info are read and the index type is irrelevant.
+ */
+int fm_map(io_cfg_type const & io_cfg, primer_cfg_type const & primer_cfg, TKLocations & locations)
+{
+    if (fm_map_counting(io_cfg, primer_cfg))
+        return fm_map<TIndex>(io_cfg, primer_cfg, locations);
+    int ret_code{0};
+    fm_flavour_apply(fm_flavour_load(io_cfg), [&](auto config_tag)
+    {
+        using TConfig = typename decltype(config_tag)::Type;
+        if (io_cfg.get_mmap())
+            ret_code = fm_map<TIndexMMapOf<TConfig> >(io_cfg, primer_cfg, locations);
+        else
+            ret_code = fm_map<TIndexOf<TConfig> >(io_cfg, primer_cfg, locations);
+    });
+    return ret_code;
+}
+
+// Streaming variant of the above, see fm_map(io_cfg, primer_cfg, TLocationQueue &).
+int fm_map(io_cfg_type const & io_cfg, primer_cfg_type const & primer_cfg, TLocationQueue & queue)
+{
+    if (fm_map_counting(io_cfg, primer_cfg))
+        return fm_map<TIndex>(io_cfg, primer_cfg, queue);
+    int ret_code{0};
+    try
+    {
+        fm_flavour_apply(fm_flavour_load(io_cfg), [&](auto config_tag)
+        {
+            using TConfig = typename decltype(config_tag)::Type;
+            if (io_cfg.get_mmap())
+                ret_code = fm_map<TIndexMMapOf<TConfig> >(io_cfg, primer_cfg, queue);
+            else
+                ret_code = fm_map<TIndexOf<TConfig> >(io_cfg, primer_cfg, queue);
+        });
+    }
+    catch (...)
+    {
+        // unknown flavour, the consumer must not wait forever
+        queue.close();
+        throw;
+    }
+    return ret_code;
+}
+
 } // namespace priset
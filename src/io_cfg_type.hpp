@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstring>
 #include <experimental/filesystem>
 #include <iostream>
@@ -60,9 +61,6 @@ public:
         index_dir = work_dir;
         mapping_dir = work_dir;
 
-        // TODO: path to PriSeT git repos as argument
-        genmap_bin = "~/git/PriSet_git2/PriSeT/submodules/genmap/bin/genmap";
-
         if (!fs::exists(lib_dir))
             std::cout << "ERROR: " << LIB_DIR_ERROR << std::endl, exit(-1);
         for (auto & p : fs::directory_iterator(lib_dir))
@@ -110,7 +108,7 @@ public:
                 std::cout << "ERROR: " << WRK_DIR_ERROR << std::endl, exit(-1);
         }
 
-        // set output directory for FM index, will be created by genmap
+        // set output directory for FM index, will be created by fm_index
         index_dir /= fs::path("/index");
         if (skip_idx_flag && !fs::exists(index_dir))
         {
@@ -168,6 +166,66 @@ public:
         return skip_idx_flag;
     }
 
+    // Set number of threads, at least one.
+    void set_threads(unsigned const threads_) noexcept
+    {
+        threads = std::max(1U, threads_);
+    }
+
+    // Return number of threads.
+    unsigned get_threads() const noexcept
+    {
+        return threads;
+    }
+
+    // Set flag for memory-mapping FM index and text corpus instead of reading them.
+    void set_mmap(bool const mmap_flag_) noexcept
+    {
+        mmap_flag = mmap_flag_;
+    }
+
+    // Return mmap flag.
+    bool get_mmap() const noexcept
+    {
+        return mmap_flag;
+    }
+
+    // Set flag for counting k-mers by sorting instead of FM index mapping (E = 0 only).
+    void set_kmer_counting(bool const kmer_counting_flag_) noexcept
+    {
+        kmer_counting_flag = kmer_counting_flag_;
+    }
+
+    // Return k-mer counting flag.
+    bool get_kmer_counting() const noexcept
+    {
+        return kmer_counting_flag;
+    }
+
+    // Set suffix array sampling rate of FM index to build, 0 for the default flavour.
+    void set_index_sampling(unsigned const index_sampling_) noexcept
+    {
+        index_sampling = index_sampling_;
+    }
+
+    // Return suffix array sampling rate of FM index to build.
+    unsigned get_index_sampling() const noexcept
+    {
+        return index_sampling;
+    }
+
+    // Set BWT length width (32 or 64 bit) of FM index to build, 0 for the smallest one fitting the text.
+    void set_index_bwt_width(unsigned const index_bwt_width_) noexcept
+    {
+        index_bwt_width = index_bwt_width_;
+    }
+
+    // Return BWT length width of FM index to build.
+    unsigned get_index_bwt_width() const noexcept
+    {
+        return index_bwt_width;
+    }
+
     // Return accession file with absolute path as filesystem::path object.
     fs::path get_acc_file() const noexcept
     {
@@ -184,16 +242,23 @@ public:
         return library_size;
     }
 
-    // Return FREQ_KMER_MIN_PERCENT relative to library size.
+    // Set kmer and kmer pair frequency cutoffs in percent of the library size.
+    void set_freq_min_percent(unsigned const freq_kmer_min_percent_, unsigned const freq_pair_min_percent_) noexcept
+    {
+        freq_kmer_min_percent = freq_kmer_min_percent_;
+        freq_pair_min_percent = freq_pair_min_percent_;
+    }
+
+    // Return kmer frequency cutoff relative to library size.
     unsigned get_freq_kmer_min() const noexcept
     {
-        return unsigned(float(FREQ_KMER_MIN_PERCENT)/float(100) * library_size);
+        return unsigned(float(freq_kmer_min_percent)/float(100) * library_size);
     }
 
-    // Return FREQ_PAIR_MIN_PERCENT relative to library size.
+    // Return kmer pair frequency cutoff relative to library size.
     unsigned get_freq_pair_min() const noexcept
     {
-        return (unsigned(float(FREQ_PAIR_MIN_PERCENT)/float(100) * library_size));
+        return (unsigned(float(freq_pair_min_percent)/float(100) * library_size));
     }
 
     // Return template file for shiny app.
@@ -208,12 +273,6 @@ public:
         return fasta_file;
     }
 
-    // Return path of genmap binary
-    fs::path get_genmap_binary() const noexcept
-    {
-        return genmap_bin;
-    }
-
     // Return directory where FM index is stored
     fs::path get_index_dir() const noexcept
     {
@@ -232,6 +291,12 @@ public:
         return index_dir / "index.ids";
     }
 
+    // path to FM index flavour information written with the index
+    fs::path get_index_info_path() const noexcept
+    {
+        return index_dir / "index.info";
+    }
+
     // return path to concatenation of text corpus stored in two files index.txt.concat and index.txt.limits
     fs::path get_index_txt_path() const noexcept
     {
@@ -288,6 +353,16 @@ private:
     bool skip_idx_flag{0};
     // Flag for indicating to do index computation exclusively.
     bool idx_only_flag{0};
+    // Number of threads used by parallel stages.
+    unsigned threads{1};
+    // Flag for indicating to memory-map FM index and text corpus.
+    bool mmap_flag{0};
+    // Flag for indicating to count k-mers by sorting instead of mapping them.
+    bool kmer_counting_flag{0};
+    // Suffix array sampling rate of FM index to build, 0 for default.
+    unsigned index_sampling{0};
+    // BWT length width of FM index to build, 0 for automatic choice.
+    unsigned index_bwt_width{0};
     // Taxid to accession map in csv format (set by PriSeT).
     fs::path acc_file{};
     // Sequence library file in fasta format (set by PriSeT).
@@ -300,8 +375,6 @@ private:
     fs::path index_dir;
     // Working subdirectory for FM index mappings (set by PriSeT).
     fs::path mapping_dir;
-    // Path to genmap binary (set by PriSeT).
-    fs::path genmap_bin;
     // Library file extensions.
     std::string ext_fasta = ".fasta";
     std::string ext_acc = ".acc";
@@ -309,6 +382,9 @@ private:
     std::string ext_id = ".id";
     // Library size in terms of number of accessions (= fasta entries)
     uint64_t library_size{0};
+    // Kmer and kmer pair frequency cutoffs in percent of the library size.
+    unsigned freq_kmer_min_percent{FREQ_KMER_MIN_PERCENT};
+    unsigned freq_pair_min_percent{FREQ_PAIR_MIN_PERCENT};
     // Path to R shiny app template
     fs::path app_template = "../PriSeT/src/app_template.R";
     // R script for launching shiny app.
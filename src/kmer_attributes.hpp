@@ -0,0 +1,129 @@
+// ============================================================================
+//                    PriSeT - The Primer Search Tool
+// ============================================================================
+//          Author: Marie Hoffmann <marie.hoffmann AT fu-berlin.de>
+//          Manual: https://github.com/mariehoffmann/PriSeT
+
+// Per-kmer chemical attributes of all encoded lengths, precomputed for combine.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <immintrin.h>
+
+#include "chemistry.hpp"
+#include "kmer_id_store.hpp"
+#include "parallel.hpp"
+#include "types.hpp"
+
+namespace priset
+{
+
+/*
+ * Attributes of the kmers encoded in one kmerID which do not depend on the pairing
+ * partner. Lane j corresponds to bit j of the length prefix kmerID >> 54, i.e. to
+ * length PRIMER_MAX_LEN - j, such that eligibility bits can be ANDed with the prefix.
+ * Tm holds the Wallace melting temperature of each encoded length, lanes beyond
+ * PREFIX_SIZE and lengths beyond the encoded one are 0. fwd has a bit set for each
+ * length passing the CG clamp and (A|T)^3 tail test as forward primer, rev has
+ * all bits set if the kmerID passes both tests as reverse primer.
+ * fourmers is a 256 bit set of the 4-mers in the longest encoded kmer, bit w
+ * marks the 4-mer with 2-bit code w. annealing is the set of their complements
+ * and reverse complements, i.e. of the 4-mers a partner may anneal with.
+ */
+struct TKmerAttributes
+{
+    uint64_t fourmers[4];
+    uint64_t annealing[4];
+    uint8_t Tm[16];
+    uint16_t fwd;
+    uint16_t rev;
+};
+
+// Compute attributes of a single kmerID.
+inline TKmerAttributes kmer_attributes(TKmerID const kmerID)
+{
+    TKmerAttributes attributes{};
+    uint64_t const code = kmerID & ~PREFIX_SELECTOR;
+    uint64_t const enc_l = encoded_length(code);  // in bits
+    for (uint64_t lane = 0; lane < PREFIX_SIZE; ++lane)
+    {
+        uint64_t const l = PRIMER_MAX_LEN - lane;
+        if ((l << 1) > enc_l)
+            continue;
+        // Tm = 2AT + 4CG = 2l + 2CG
+        uint64_t const infix = (code >> (enc_l - (l << 1))) & ((1ULL << (l << 1)) - 1);
+        attributes.Tm[lane] = (l + __builtin_popcountll(CG_BITS(infix))) << 1;
+        uint64_t const mask = ONE_LSHIFT_63 >> (l - PRIMER_MIN_LEN);
+        if (filter_CG_clamp(kmerID, '+', mask) && filter_WWW_tail(kmerID, '+', mask))
+            attributes.fwd |= 1 << lane;
+    }
+    if (filter_CG_clamp(kmerID, '-') && filter_WWW_tail(kmerID, '-'))
+        attributes.rev = (1 << PREFIX_SIZE) - 1;
+    // 4-mers in the order scanned by filter_cross_annealing
+    for (uint64_t infixes = code; infixes >= (1 << 8); infixes >>= 2)
+    {
+        uint64_t const infix = infixes & 0b11111111;
+        uint64_t const infix_compl = ~infix & 0b11111111;
+        uint64_t const infix_rev = ((infix_compl & 0b11) << 6) + ((infix_compl & 0b1100) << 2) + ((infix_compl & 0b110000) >> 2) + ((infix_compl & 0b11000000) >> 6);
+        attributes.fourmers[infix >> 6] |= 1ULL << (infix & 63);
+        attributes.annealing[infix_compl >> 6] |= 1ULL << (infix_compl & 63);
+        attributes.annealing[infix_rev >> 6] |= 1ULL << (infix_rev & 63);
+    }
+    return attributes;
+}
+
+/*
+ * Compute the attributes of all kmerIDs in the layout of kmerIDs, i.e. the attributes
+ * of the i-th kmerID of reference seqNo_cx are stored at kmerIDs.offset(seqNo_cx) + i.
+ * References are processed on `threads` threads.
+ */
+inline void kmer_attributes(TKmerIDs const & kmerIDs, std::vector<TKmerAttributes> & attributes, unsigned const threads = 1)
+{
+    attributes.resize(kmerIDs.num_kmerIDs());
+    parallel_for(kmerIDs.size(), threads, [&](uint64_t const seqNo_cx, unsigned const)
+    {
+        TKmerID const * const kmerIDs_reference = kmerIDs.data(seqNo_cx);
+        TKmerAttributes * const attributes_reference = attributes.data() + kmerIDs.offset(seqNo_cx);
+        for (uint64_t i = 0; i < kmerIDs.size(seqNo_cx); ++i)
+            attributes_reference[i] = kmer_attributes(kmerIDs_reference[i]);
+    });
+}
+
+/*
+ * Return the lanes of rev whose melting temperature differs by at most dTm_max
+ * from the one of lane `lane` of fwd. All 16 lanes are compared at once with
+ * saturated differences.
+ */
+inline uint16_t Tm_partners(TKmerAttributes const & fwd, uint64_t const lane, TKmerAttributes const & rev, __m128i const dTm_max)
+{
+    __m128i const Tm_fwd = _mm_set1_epi8(fwd.Tm[lane]);
+    __m128i const Tm_rev = _mm_loadu_si128(reinterpret_cast<__m128i const *>(rev.Tm));
+    __m128i const diff = _mm_or_si128(_mm_subs_epu8(Tm_fwd, Tm_rev), _mm_subs_epu8(Tm_rev, Tm_fwd));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(diff, dTm_max), diff));
+}
+
+/*
+ * Return true if a 4-mer of fwd is complementary or reverse complementary to one
+ * of rev. Otherwise filter_cross_annealing(fwd, rev) does not change any length
+ * bits and can be skipped.
+ */
+inline bool cross_annealing_candidate(TKmerAttributes const & fwd, TKmerAttributes const & rev) noexcept
+{
+    return (fwd.fourmers[0] & rev.annealing[0]) | (fwd.fourmers[1] & rev.annealing[1]) |
+           (fwd.fourmers[2] & rev.annealing[2]) | (fwd.fourmers[3] & rev.annealing[3]);
+}
+
+// AVX2 variant of the above testing all 256 bits at once.
+__attribute__((target("avx2")))
+inline bool cross_annealing_candidate_avx2(TKmerAttributes const & fwd, TKmerAttributes const & rev) noexcept
+{
+    __m256i const fourmers = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(fwd.fourmers));
+    __m256i const annealing = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(rev.annealing));
+    return !_mm256_testz_si256(fourmers, annealing);
+}
+
+} // namespace priset
@@ -0,0 +1,193 @@
+// ============================================================================
+//                    PriSeT - The Primer Search Tool
+// ============================================================================
+//          Author: Marie Hoffmann <marie.hoffmann AT fu-berlin.de>
+//          Manual: https://github.com/mariehoffmann/PriSeT
+
+// Exact k-mer counting by sorting hash-partitioned positions, an alternative to FM index mapping for E = 0.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <seqan/sequence.h>
+
+#include "location_store.hpp"
+#include "parallel.hpp"
+#include "primer_cfg_type.hpp"
+#include "types.hpp"
+
+namespace priset
+{
+
+// Number of text positions per segment scanned by one task.
+#define KMER_COUNT_PARTITION_SIZE (1ULL << 24)
+
+// Number of text positions whose candidates, 16 bytes each, are buffered in one batch of partitions.
+#define KMER_COUNT_BATCH_SIZE (1ULL << 26)
+
+// Report locations of a frequent k-mer of length K as one k-mer group keyed by its leftmost occurrence.
+inline void kmer_report(TKmerLength const K, std::vector<TLocation> & locs, TKLocations & locations)
+{
+    locations.append(K, locs.front(), locs);
+}
+
+// Push locations of a frequent k-mer of length K as one group into the queue, locs is moved.
+inline void kmer_report(TKmerLength const K, std::vector<TLocation> & locs, TLocationQueue & queue)
+{
+    queue.push(TLocationGroup{K, std::move(locs)});
+}
+
+/*
+ * Rolling 2-bit encoder, calls f(seqPos, code, len) for every position seqPos in
+ * [begin, end) of seq followed by at least K_min bases. code holds the len =
+ * min(K_max, bases left) bases starting at seqPos, the first base in the most
+ * significant bits, hence codes of k-mers of equal length compare lexicographically.
+ * Bases other than A, C, G and T (N in Dna5 sequences) do not belong to any k-mer,
+ * the window restarts behind them. K_max <= 32.
+ */
+template<typename TSeq, typename TFunc>
+void kmer_roll(TSeq const & seq, uint64_t const begin, uint64_t const end, uint64_t const K_min, uint64_t const K_max, TFunc && f)
+{
+    uint64_t const stop = std::min<uint64_t>(seqan::length(seq), end + K_max - 1);
+    uint64_t const mask = (K_max < 32) ? (1ULL << (K_max << 1)) - 1 : ~0ULL;
+    // codes of the last `valid` bases, at most K_max
+    uint64_t code = 0;
+    uint64_t valid = 0;
+    // report positions whose bases end before i with less than K_max bases
+    auto flush = [&](uint64_t const i)
+    {
+        for (uint64_t len = std::min(valid, K_max - 1); len >= K_min; --len)
+            if (i - len < end)
+                f(i - len, code & ((1ULL << (len << 1)) - 1), len);
+    };
+    for (uint64_t i = begin; i < stop; ++i)
+    {
+        uint64_t const c = seqan::ordValue(seq[i]);
+        if (c > 3)
+        {
+            flush(i);
+            valid = 0;
+            continue;
+        }
+        code = ((code << 2) | c) & mask;
+        valid = std::min(valid + 1, K_max);
+        if (valid == K_max && i + 1 - K_max < end)
+            f(i + 1 - K_max, code, K_max);
+    }
+    flush(stop);
+}
+
+// Partition of a k-mer code.
+inline uint64_t kmer_partition(uint64_t const code, uint64_t const partitions)
+{
+    return ((code * 0x9E3779B97F4A7C15ULL) >> 32) % partitions;
+}
+
+// Range [begin, end) of k-mer start positions in sequence seqNo scanned by one task.
+struct TKmerSegment
+{
+    TSeqNo seqNo;
+    TSeqPos begin;
+    TSeqPos end;
+};
+
+// Position of a K_min-mer with the code of up to K_max bases starting there.
+struct TKmerCandidate
+{
+    // 2-bit code of len bases, left-aligned to 2 * K_max bits, followed by len in the lowest 6 bits
+    uint64_t code;
+    // location packed by TLocationCodec
+    uint64_t location;
+};
+
+/*
+ * Count the k-mers of all lengths in [K_min, K_max] in text and report those
+ * occurring at least freq_kmer_min times exactly, which are the k-mer groups
+ * fm_map reports for E = 0. K_min and K_max lie within [PRIMER_MIN_LEN,
+ * PRIMER_MAX_LEN]. The K_min-mers are hashed into `threads` partitions per batch
+ * of KMER_COUNT_BATCH_SIZE text positions, and the batches of partitions are
+ * processed one after another, each on `threads` threads in two phases:
+ * (i) the text is split into segments of KMER_COUNT_PARTITION_SIZE positions and
+ *     scanned, each position whose K_min-mer falls into a partition of the batch
+ *     is put with its extension up to K_max bases into the bucket of its segment
+ *     and partition,
+ * (ii) per partition the buckets of all segments are sorted by code, so all k-mers
+ *      sharing a prefix of length K are adjacent, and runs of at least freq_kmer_min
+ *      positions are reported for each K.
+ * Hence, the text is scanned once per batch and only the candidates of one batch,
+ * about 16 bytes per position of KMER_COUNT_BATCH_SIZE, are held at a time.
+ * out      callable returning the output of a thread given its id
+ */
+template<typename TText, typename TOutOfThread>
+void kmer_count_traverse(TText const & text, uint64_t const K_min, uint64_t const K_max, unsigned const freq_kmer_min, unsigned const threads, TOutOfThread && out)
+{
+    TLocationCodec const codec{seqan::length(text)};
+    std::vector<TKmerSegment> segments;
+    for (TSeqNo seqNo = 0; seqNo < seqan::length(text); ++seqNo)
+    {
+        TSeqPos const length = seqan::length(text[seqNo]);
+        for (TSeqPos begin = 0; begin < length; begin += KMER_COUNT_PARTITION_SIZE)
+            segments.push_back(TKmerSegment{seqNo, begin, std::min<TSeqPos>(begin + KMER_COUNT_PARTITION_SIZE, length)});
+    }
+    uint64_t const batch_partitions = std::max(1U, threads);
+    uint64_t const partitions = (seqan::lengthSum(text) / KMER_COUNT_BATCH_SIZE + 1) * batch_partitions;
+
+    std::vector<std::vector<TKmerCandidate> > buckets(segments.size() * batch_partitions);
+    for (uint64_t batch_begin = 0; batch_begin < partitions; batch_begin += batch_partitions)
+    {
+        // (i) bucket positions of the batch by segment and partition
+        parallel_for(segments.size(), threads, [&](uint64_t const segment, unsigned const)
+        {
+            auto const & [seqNo, begin, end] = segments[segment];
+            kmer_roll(text[seqNo], begin, end, K_min, K_max, [&](TSeqPos const seqPos, uint64_t const code, uint64_t const len)
+            {
+                uint64_t const code_aligned = code << ((K_max - len) << 1);
+                uint64_t const partition = kmer_partition(code_aligned >> ((K_max - K_min) << 1), partitions);
+                if (partition >= batch_begin && partition < batch_begin + batch_partitions)
+                    buckets[segment * batch_partitions + partition - batch_begin].push_back(TKmerCandidate{(code_aligned << 6) | len, codec.encode(seqNo, seqPos)});
+            });
+        });
+
+        // (ii) report k-mers of length K as runs of equal prefixes per partition
+        parallel_for(batch_partitions, threads, [&](uint64_t const partition, unsigned const thread_id)
+        {
+            std::vector<TKmerCandidate> candidates;
+            for (uint64_t segment = 0; segment < segments.size(); ++segment)
+            {
+                std::vector<TKmerCandidate> & bucket = buckets[segment * batch_partitions + partition];
+                candidates.insert(candidates.end(), bucket.begin(), bucket.end());
+                std::vector<TKmerCandidate>().swap(bucket);
+            }
+            std::sort(candidates.begin(), candidates.end(), [](TKmerCandidate const & lhs, TKmerCandidate const & rhs)
+            {
+                return lhs.code < rhs.code;
+            });
+            std::vector<TLocation> locs;
+            for (uint64_t K = K_min; K <= K_max; ++K)
+            {
+                uint64_t const shift = ((K_max - K) << 1) + 6;
+                for (uint64_t i = 0; i < candidates.size();)
+                {
+                    uint64_t const prefix = candidates[i].code >> shift;
+                    locs.clear();
+                    for (; i < candidates.size() && (candidates[i].code >> shift) == prefix; ++i)
+                    {
+                        // positions without K bases left share the prefix padded by A's
+                        if ((candidates[i].code & 63) >= K)
+                            locs.push_back(codec.decode(candidates[i].location));
+                    }
+                    if (locs.size() && locs.size() >= freq_kmer_min)
+                    {
+                        std::sort(locs.begin(), locs.end());
+                        kmer_report(K, locs, out(thread_id));
+                    }
+                }
+            }
+        });
+    }
+}
+
+} // namespace priset
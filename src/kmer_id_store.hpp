@@ -0,0 +1,159 @@
+// ============================================================================
+//                    PriSeT - The Primer Search Tool
+// ============================================================================
+//          Author: Marie Hoffmann <marie.hoffmann AT fu-berlin.de>
+//          Manual: https://github.com/mariehoffmann/PriSeT
+
+// Contiguous store of kmerIDs and their positions per reference.
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "types.hpp"
+
+namespace priset
+{
+
+/*
+ * The kmerIDs of all references in compressed sparse row layout. The kmerIDs of
+ * the reference with compressed identifier seqNo_cx are stored in order of their
+ * positions in kmerIDs[offsets[seqNo_cx]:offsets[seqNo_cx+1]]. The ascending
+ * positions of the kmerIDs are stored next to them in the same layout, such that
+ * windows of kmers can be scanned without rank and select queries. References are appended in order
+ * of seqNo_cx, and kmerIDs to the last reference in order of their positions.
+ */
+class TKmerIDs
+{
+public:
+    using value_type = TKmerID;
+    using const_iterator = std::vector<TKmerID>::const_iterator;
+
+    TKmerIDs() = default;
+
+    // Remove all references and kmerIDs.
+    void clear() noexcept
+    {
+        kmerIDs.clear();
+        positions.clear();
+        offsets.assign(1, 0);
+    }
+
+    // Append a reference without kmerIDs.
+    void add_reference()
+    {
+        offsets.push_back(offsets.back());
+    }
+
+    // Append kmerID with position seqPos to the last reference.
+    void push_back(TKmerID const kmerID, TSeqPos const seqPos)
+    {
+        kmerIDs.push_back(kmerID);
+        positions.push_back(seqPos);
+        ++offsets.back();
+    }
+
+    // Append a reference with the kmerIDs in [first, last) and their positions starting at first_pos.
+    template<typename TIter, typename TPosIter>
+    void append_reference(TIter const first, TIter const last, TPosIter const first_pos)
+    {
+        kmerIDs.insert(kmerIDs.end(), first, last);
+        positions.insert(positions.end(), first_pos, first_pos + (kmerIDs.size() - positions.size()));
+        offsets.push_back(kmerIDs.size());
+    }
+
+    // Number of references.
+    uint64_t size() const noexcept
+    {
+        return offsets.size() - 1;
+    }
+
+    bool empty() const noexcept
+    {
+        return offsets.size() == 1;
+    }
+
+    // Number of kmerIDs of reference seqNo_cx.
+    uint64_t size(uint64_t const seqNo_cx) const noexcept
+    {
+        return offsets[seqNo_cx + 1] - offsets[seqNo_cx];
+    }
+
+    // Index of the first kmerID of reference seqNo_cx in the concatenation.
+    uint64_t offset(uint64_t const seqNo_cx) const noexcept
+    {
+        return offsets[seqNo_cx];
+    }
+
+    // Total number of kmerIDs over all references.
+    uint64_t num_kmerIDs() const noexcept
+    {
+        return kmerIDs.size();
+    }
+
+    // Return i-th kmerID (0-based rank) of reference seqNo_cx.
+    TKmerID operator()(uint64_t const seqNo_cx, uint64_t const i) const noexcept
+    {
+        return kmerIDs[offsets[seqNo_cx] + i];
+    }
+
+    // Bounds-checked variant of the above, throws std::out_of_range.
+    TKmerID at(uint64_t const seqNo_cx, uint64_t const i) const
+    {
+        if (seqNo_cx >= size() || i >= size(seqNo_cx))
+            throw std::out_of_range("TKmerIDs: no kmerID " + std::to_string(i) + " in reference " + std::to_string(seqNo_cx));
+        return kmerIDs[offsets[seqNo_cx] + i];
+    }
+
+    // Return position of the i-th kmerID (0-based rank) of reference seqNo_cx.
+    TSeqPos position(uint64_t const seqNo_cx, uint64_t const i) const noexcept
+    {
+        return positions[offsets[seqNo_cx] + i];
+    }
+
+    // Contiguous kmerIDs and positions of reference seqNo_cx.
+    TKmerID const * data(uint64_t const seqNo_cx) const noexcept
+    {
+        return kmerIDs.data() + offsets[seqNo_cx];
+    }
+
+    TSeqPos const * positions_data(uint64_t const seqNo_cx) const noexcept
+    {
+        return positions.data() + offsets[seqNo_cx];
+    }
+
+    // Iterators over the kmerIDs of reference seqNo_cx.
+    const_iterator begin(uint64_t const seqNo_cx) const noexcept
+    {
+        return kmerIDs.begin() + offsets[seqNo_cx];
+    }
+
+    const_iterator end(uint64_t const seqNo_cx) const noexcept
+    {
+        return kmerIDs.begin() + offsets[seqNo_cx + 1];
+    }
+
+    // Iterators over the kmerIDs of all references.
+    const_iterator begin() const noexcept
+    {
+        return kmerIDs.begin();
+    }
+
+    const_iterator end() const noexcept
+    {
+        return kmerIDs.end();
+    }
+
+private:
+    // Concatenated kmerIDs of all references.
+    std::vector<TKmerID> kmerIDs;
+    // Positions of kmerIDs in their reference.
+    std::vector<TSeqPos> positions;
+    // Start offsets of references into kmerIDs followed by the total size.
+    std::vector<uint64_t> offsets{0};
+};
+
+} // namespace priset
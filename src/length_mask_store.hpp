@@ -0,0 +1,125 @@
+// ============================================================================
+//                    PriSeT - The Primer Search Tool
+// ============================================================================
+//          Author: Marie Hoffmann <marie.hoffmann AT fu-berlin.de>
+//          Manual: https://github.com/mariehoffmann/PriSeT
+
+// Length masks of k-mer locations of one reference indexed by the rank of their position.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "../submodules/sdsl-lite/include/sdsl/bit_vectors.hpp"
+
+#include "primer_cfg_type.hpp"
+#include "types.hpp"
+
+namespace priset
+{
+
+// Width of a length mask, the 10 length bits of the kmerID prefix above a drop bit.
+#define LENGTH_MASK_SIZE (PREFIX_SIZE + 1)
+
+// Number of buffered masks up to which a reference is not merged independent of its size.
+#define LENGTH_MASK_BUFFER_MIN 64
+
+/*
+ * Length masks of the k-mer locations of one reference. A bit vector marks the
+ * candidate positions, the mask of a candidate is stored at the rank of its
+ * position. Masks are registered in any order and ORed per position, they are
+ * buffered as records seqPos << LENGTH_MASK_SIZE | mask and merged once the buffer
+ * exceeds an eighth of the candidates. Hence, a reference costs one bit per base
+ * up to its last candidate and 11 bits per candidate, and the buffer at most one
+ * byte per candidate next to LENGTH_MASK_BUFFER_MIN records.
+ */
+class TReferenceMasks
+{
+public:
+    TReferenceMasks() = default;
+
+    // OR mask into the mask of seqPos.
+    void add(TSeqPos const seqPos, uint16_t const mask)
+    {
+        buffer.push_back((seqPos << LENGTH_MASK_SIZE) | mask);
+        if (buffer.size() > (masks.size() >> 3) + LENGTH_MASK_BUFFER_MIN)
+            merge();
+    }
+
+    // Merge buffered masks into the bit vector and the rank indexed masks.
+    void merge()
+    {
+        if (buffer.empty())
+            return;
+        std::sort(buffer.begin(), buffer.end());
+        uint64_t const length = std::max<uint64_t>(positions.size(), (buffer.back() >> LENGTH_MASK_SIZE) + 1);
+        sdsl::bit_vector positions_merged(length, 0);
+        std::copy(positions.data(), positions.data() + ((positions.size() + 63) >> 6), positions_merged.data());
+        for (uint64_t const record : buffer)
+            positions_merged[record >> LENGTH_MASK_SIZE] = 1;
+
+        // walk candidates in order of their positions, old masks have consecutive ranks
+        sdsl::int_vector<LENGTH_MASK_SIZE> masks_merged(sdsl::util::cnt_one_bits(positions_merged), 0);
+        uint64_t rank{0}, rank_old{0}, i{0};
+        for (uint64_t word = 0; word < ((length + 63) >> 6); ++word)
+        {
+            for (uint64_t bits = positions_merged.data()[word]; bits; bits &= bits - 1)
+            {
+                TSeqPos const seqPos = (word << 6) + __builtin_ctzll(bits);
+                uint64_t mask{0};
+                if (seqPos < positions.size() && positions[seqPos])
+                    mask = masks[rank_old++];
+                for (; i < buffer.size() && (buffer[i] >> LENGTH_MASK_SIZE) == seqPos; ++i)
+                    mask |= buffer[i];
+                masks_merged[rank++] = mask & ((1ULL << LENGTH_MASK_SIZE) - 1);
+            }
+        }
+        positions.swap(positions_merged);
+        masks.swap(masks_merged);
+        buffer.clear();
+    }
+
+    // True if no mask has been registered.
+    bool empty() const noexcept
+    {
+        return !masks.size() && buffer.empty();
+    }
+
+    // Number of candidates, buffered masks are counted after merge.
+    uint64_t size() const noexcept
+    {
+        return masks.size();
+    }
+
+    // Bit vector of candidate positions.
+    sdsl::bit_vector const & candidates() const noexcept
+    {
+        return positions;
+    }
+
+    // Mask of the candidate with given rank.
+    uint16_t operator[](uint64_t const rank) const
+    {
+        return masks[rank];
+    }
+
+    // Release all masks.
+    void clear()
+    {
+        sdsl::bit_vector().swap(positions);
+        sdsl::int_vector<LENGTH_MASK_SIZE>().swap(masks);
+        std::vector<uint64_t>().swap(buffer);
+    }
+
+private:
+    // Set bit for each candidate position.
+    sdsl::bit_vector positions;
+    // Masks in order of candidate positions.
+    sdsl::int_vector<LENGTH_MASK_SIZE> masks;
+    // Unordered records of masks not yet merged.
+    std::vector<uint64_t> buffer;
+};
+
+}  // namespace priset
@@ -0,0 +1,292 @@
+// ============================================================================
+//                    PriSeT - The Primer Search Tool
+// ============================================================================
+//          Author: Marie Hoffmann <marie.hoffmann AT fu-berlin.de>
+//          Manual: https://github.com/mariehoffmann/PriSeT
+
+// Flat columnar store of k-mer locations produced by the mapper.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "types.hpp"
+
+namespace priset
+{
+
+/*
+ * Packs a location (seqNo, seqPos) into 64 bits. The sequence number takes as many
+ * bits as needed for the number of sequences of the loaded text, the remaining low
+ * bits hold the position. Locations out of range are caught by an assertion.
+ * Unlike location_encode positions beyond 2^32 are safe for libraries of less than
+ * 2^32 sequences. Packed locations preserve the lexicographical order of locations.
+ */
+struct TLocationCodec
+{
+    // Default width of sequence numbers is 32 bit.
+    explicit TLocationCodec(uint64_t const library_size = (1ULL << 32) - 1) :
+        pos_width(__builtin_clzll(library_size | 1ULL)),
+        pos_mask((1ULL << pos_width) - 1)
+    {}
+
+    uint64_t encode(TSeqNo const seqNo, TSeqPos const seqPos) const noexcept
+    {
+        assert(seqPos <= pos_mask && ((seqNo << pos_width) >> pos_width) == seqNo);
+        return (seqNo << pos_width) | seqPos;
+    }
+
+    TSeqNo seqNo(uint64_t const location) const noexcept
+    {
+        return location >> pos_width;
+    }
+
+    TSeqPos seqPos(uint64_t const location) const noexcept
+    {
+        return location & pos_mask;
+    }
+
+    TLocation decode(uint64_t const location) const noexcept
+    {
+        return TLocation{seqNo(location), seqPos(location)};
+    }
+
+    uint8_t pos_width;
+    uint64_t pos_mask;
+};
+
+// Read-only range over packed locations, dereferences to TLocation.
+class TLocationRange
+{
+public:
+    class const_iterator
+    {
+    public:
+        const_iterator(uint64_t const * ptr_, TLocationCodec const & codec_) : ptr{ptr_}, codec{codec_} {}
+
+        TLocation operator*() const noexcept
+        {
+            return codec.decode(*ptr);
+        }
+
+        const_iterator & operator++() noexcept
+        {
+            ++ptr;
+            return *this;
+        }
+
+        bool operator!=(const_iterator const & rhs) const noexcept
+        {
+            return ptr != rhs.ptr;
+        }
+
+    private:
+        uint64_t const * ptr;
+        TLocationCodec codec;
+    };
+
+    TLocationRange(uint64_t const * first_, uint64_t const * last_, TLocationCodec const & codec_) :
+        first{first_}, last{last_}, codec{codec_} {}
+
+    const_iterator begin() const noexcept
+    {
+        return const_iterator(first, codec);
+    }
+
+    const_iterator end() const noexcept
+    {
+        return const_iterator(last, codec);
+    }
+
+    uint64_t size() const noexcept
+    {
+        return last - first;
+    }
+
+    TLocation operator[](uint64_t const i) const noexcept
+    {
+        return codec.decode(first[i]);
+    }
+
+private:
+    uint64_t const * first;
+    uint64_t const * last;
+    TLocationCodec codec;
+};
+
+/*
+ * The k-mer locations augmented by K in compressed sparse row layout. A k-mer group
+ * holds all (approximate) occurrences of a frequent k-mer of length K, i.e. of one
+ * k-mer interval in the index, which are stored once as packed locations in
+ * locations[offsets[g]:offsets[g+1]]. There is one key (seqNo, seqPos, K) per group
+ * with the leftmost exact occurrence as its representative. Key columns are in
+ * lexicographical order after sort(), which makes the group order independent of
+ * the order groups were appended in.
+ */
+class TKLocations
+{
+public:
+    TKLocations() = default;
+
+    // Size location packing for a library of library_size sequences.
+    explicit TKLocations(uint64_t const library_size) : codec{library_size} {}
+
+    // Remove all k-mer groups and size location packing for library_size sequences.
+    void reset(uint64_t const library_size)
+    {
+        *this = TKLocations(library_size);
+    }
+
+    // Remove all k-mer groups.
+    void clear()
+    {
+        *this = TKLocations(codec);
+    }
+
+    // Append k-mer group of length K with its representative exact occurrence `key`.
+    void append(TKmerLength const K, TLocation const & key, std::vector<TLocation> const & locs)
+    {
+        key_locations.push_back(codec.encode(seqan::getValueI1(key), seqan::getValueI2(key)));
+        key_Ks.push_back(K);
+        key_groups.push_back(group_Ks.size());
+        group_Ks.push_back(K);
+        for (TLocation const & loc : locs)
+            locations.push_back(codec.encode(seqan::getValueI1(loc), seqan::getValueI2(loc)));
+        offsets.push_back(locations.size());
+        sorted = false;
+    }
+
+    // Move all k-mer groups of other to the end of this store, other has to use the same packing.
+    void merge(TKLocations & other)
+    {
+        uint64_t const group_offset = group_Ks.size();
+        uint64_t const location_offset = locations.size();
+        group_Ks.insert(group_Ks.end(), other.group_Ks.begin(), other.group_Ks.end());
+        for (auto it = other.offsets.begin() + 1; it != other.offsets.end(); ++it)
+            offsets.push_back(*it + location_offset);
+        locations.insert(locations.end(), other.locations.begin(), other.locations.end());
+        key_locations.insert(key_locations.end(), other.key_locations.begin(), other.key_locations.end());
+        key_Ks.insert(key_Ks.end(), other.key_Ks.begin(), other.key_Ks.end());
+        for (uint64_t const group : other.key_groups)
+            key_groups.push_back(group + group_offset);
+        sorted = false;
+        other.clear();
+    }
+
+    /*
+     * Sort keys lexicographically by (seqNo, seqPos, K) with a least significant
+     * digit radix sort on 8 bit digits. Digits equal for all keys are skipped.
+     */
+    void sort()
+    {
+        if (sorted)
+            return;
+        uint64_t const n = key_Ks.size();
+        std::vector<uint64_t> perm(n), perm_next(n);
+        for (uint64_t i = 0; i < n; ++i)
+            perm[i] = i;
+        auto radix_pass = [&](auto && digit)
+        {
+            std::array<uint64_t, 257> counts{};
+            for (uint64_t i = 0; i < n; ++i)
+                ++counts[digit(i) + 1];
+            if (std::any_of(counts.begin() + 1, counts.end(), [n](uint64_t const c){ return c == n; }))
+                return;
+            for (unsigned d = 1; d < counts.size(); ++d)
+                counts[d] += counts[d - 1];
+            for (uint64_t i = 0; i < n; ++i)
+                perm_next[counts[digit(perm[i])]++] = perm[i];
+            std::swap(perm, perm_next);
+        };
+        radix_pass([&](uint64_t const i){ return uint8_t(key_Ks[i]); });
+        for (unsigned shift = 0; shift < 64; shift += 8)
+            radix_pass([&](uint64_t const i){ return uint8_t(key_locations[i] >> shift); });
+
+        auto gather = [&](auto & column)
+        {
+            std::remove_reference_t<decltype(column)> column_sorted(n);
+            for (uint64_t i = 0; i < n; ++i)
+                column_sorted[i] = column[perm[i]];
+            column.swap(column_sorted);
+        };
+        gather(key_locations);
+        gather(key_Ks);
+        gather(key_groups);
+        sorted = true;
+    }
+
+    // Number of keys, equal to the number of k-mer groups.
+    uint64_t size() const noexcept
+    {
+        return key_Ks.size();
+    }
+
+    bool empty() const noexcept
+    {
+        return key_Ks.empty();
+    }
+
+    // Return i-th key as (seqNo, seqPos, K).
+    TKLocation key(uint64_t const i) const noexcept
+    {
+        return std::make_tuple(codec.seqNo(key_locations[i]), codec.seqPos(key_locations[i]), TKmerLength(key_Ks[i]));
+    }
+
+    // Return k-mer group of i-th key.
+    uint64_t group(uint64_t const i) const noexcept
+    {
+        return key_groups[i];
+    }
+
+    // Number of k-mer groups.
+    uint64_t groups() const noexcept
+    {
+        return group_Ks.size();
+    }
+
+    // Return K of k-mer group.
+    TKmerLength group_length(uint64_t const group) const noexcept
+    {
+        return group_Ks[group];
+    }
+
+    // Return locations of k-mer group in lexicographical order.
+    TLocationRange group_locations(uint64_t const group) const noexcept
+    {
+        return TLocationRange(locations.data() + offsets[group], locations.data() + offsets[group + 1], codec);
+    }
+
+    // Total number of locations over all k-mer groups.
+    uint64_t num_locations() const noexcept
+    {
+        return locations.size();
+    }
+
+    TLocationCodec const & get_codec() const noexcept
+    {
+        return codec;
+    }
+
+private:
+    explicit TKLocations(TLocationCodec const & codec_) : codec{codec_} {}
+
+    TLocationCodec codec{};
+    // Key columns: packed representative location, K, and k-mer group.
+    std::vector<uint64_t> key_locations;
+    std::vector<uint8_t> key_Ks;
+    std::vector<uint64_t> key_groups;
+    // K of k-mer groups and their offsets into packed locations.
+    std::vector<uint8_t> group_Ks;
+    std::vector<uint64_t> offsets{0};
+    std::vector<uint64_t> locations;
+    // Flag indicating if key columns are in lexicographical order.
+    bool sorted{1};
+};
+
+} // namespace priset
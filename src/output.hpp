@@ -10,6 +10,7 @@
 #include "chemistry.hpp"
 #include "combine_types.hpp"
 #include "io_cfg_type.hpp"
+#include "kmer_id_store.hpp"
 #include "primer_cfg_type.hpp"
 #include "types.hpp"
 #include "utilities.hpp"
@@ -27,7 +28,7 @@ std::string dna_decoder(uint64_t code, uint64_t const mask);
 template<typename io_cfg_type, typename primer_cfg_type, typename TKmerIDs>
 void write_primer_info_file(io_cfg_type const & io_cfg, primer_cfg_type const & primer_cfg, TKmerIDs const & kmerIDs)
 {
-    using TKmerID = typename TKmerIDs::value_type::value_type;
+    using TKmerID = typename TKmerIDs::value_type;
     std::ofstream primer_table;
     primer_table.open(io_cfg.get_primer_info_file());
     primer_table << "id,kmer_sequence,coverage_tax,coverage_ref,length,CG,Tm\n";
@@ -53,8 +54,8 @@ void write_primer_file(TKmerIDs const & kmerIDs, TPairList const & pairs, fs::pa
     // TPair<TCombinePattern<TKmerID, TKmerLength>>
     for (auto pair : pairs)
     {
-        uint64_t kmer_fwd = kmerIDs.at(pair.reference).at(pair.r_fwd - 1);
-        uint64_t kmer_rev = kmerIDs.at(pair.reference).at(pair.r_rev - 1);
+        uint64_t kmer_fwd = kmerIDs.at(pair.reference, pair.r_fwd - 1);
+        uint64_t kmer_rev = kmerIDs.at(pair.reference, pair.r_rev - 1);
 
         for (uint8_t i = 0; i < 100; ++i)
         {
@@ -107,8 +108,8 @@ void unfold_pairs(TPairList const & pairs, TKmerIDs const & kmerIDs, TPair2RefMa
     for (auto pair : pairs)
     {
         auto refID = pair.reference;
-        auto code1 = ~PREFIX_SELECTOR & kmerIDs.at(refID).at(pair.r_fwd - 1);
-        auto code2 = ~PREFIX_SELECTOR & kmerIDs.at(refID).at(pair.r_rev - 1);
+        auto code1 = ~PREFIX_SELECTOR & kmerIDs.at(refID, pair.r_fwd - 1);
+        auto code2 = ~PREFIX_SELECTOR & kmerIDs.at(refID, pair.r_rev - 1);
         std::vector<std::pair<uint8_t, uint8_t>> combinations;
         pair.cp.get_combinations(combinations);
         for (auto combination : combinations)
@@ -141,10 +142,10 @@ void unfold_pairs(TPairList const & pairs, TKmerIDs const & kmerIDs, TPair2RefMa
     Tm          melting temperature
     CG          CG content as float
 */
-template<typename io_cfg_type, typename primer_cfg_type, typename TPairList, typename TSeqNoMap, typename TReferences, typename TKmerIDs>
-void create_table(io_cfg_type const & io_cfg, primer_cfg_type const & primer_cfg, /*TSeqNoMap const & seqNoMap,*/TReferences const & references, TKmerIDs const & kmerIDs, TPairList const & pairs)
+template<typename io_cfg_type, typename primer_cfg_type, typename TPairList, typename TSeqNoMap, typename TKmerIDs>
+void create_table(io_cfg_type const & io_cfg, primer_cfg_type const & primer_cfg, /*TSeqNoMap const & seqNoMap,*/TKmerIDs const & kmerIDs, TPairList const & pairs)
 {
-    //using TKmerID = typename TKmerIDs::value_type::value_type;
+    //using TKmerID = typename TKmerIDs::value_type;
     //std::set<uint64_t> kmer_ordered_set;
     //unique_kmers(kmerIDs, kmer_ordered_set);
     // pair: code fwd, code rev referring to list of reference IDs
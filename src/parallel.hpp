@@ -0,0 +1,119 @@
+// ============================================================================
+//                    PriSeT - The Primer Search Tool
+// ============================================================================
+//          Author: Marie Hoffmann <marie.hoffmann AT fu-berlin.de>
+//          Manual: https://github.com/mariehoffmann/PriSeT
+
+// Helpers for running independent tasks on a pool of threads.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace priset
+{
+
+/*
+ * Run task(i, thread_id) for all i in [0, n) on `threads` threads including the
+ * calling one. Task indices are handed out one at a time by an atomic counter,
+ * so tasks of varying size balance out across threads. The thread_id in
+ * [0, threads) can be used to address thread-local output buffers. If a task
+ * throws, no further tasks are started and the first exception is rethrown
+ * after all threads joined.
+ */
+template<typename TTask>
+void parallel_for(uint64_t const n, unsigned const threads, TTask && task)
+{
+    std::atomic<uint64_t> next{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto worker = [&](unsigned const thread_id)
+    {
+        try
+        {
+            for (uint64_t i = next++; i < n; i = next++)
+                task(i, thread_id);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error)
+                error = std::current_exception();
+            next = n;
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < std::min<uint64_t>(threads, n); ++t)
+        pool.emplace_back(worker, t);
+    worker(0);
+    for (auto & thread : pool)
+        thread.join();
+    if (error)
+        std::rethrow_exception(error);
+}
+
+/*
+ * Blocking multi-producer/multi-consumer queue with bounded capacity. Producers
+ * wait while the queue is full, consumers wait while it is empty and not closed.
+ * After close() remaining items are still handed out, then pop() returns false.
+ */
+template<typename T>
+class bounded_queue
+{
+public:
+    explicit bounded_queue(size_t const capacity_ = 1 << 12) : capacity{std::max<size_t>(1, capacity_)} {}
+
+    // Append item, blocks while queue is full. Items pushed after close() are dropped.
+    void push(T && item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [this]{ return items.size() < capacity || closed; });
+        if (closed)
+            return;
+        items.push_back(std::move(item));
+        lock.unlock();
+        not_empty.notify_one();
+    }
+
+    // Remove front item, blocks while queue is empty. Returns false if queue is closed and drained.
+    bool pop(T & item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [this]{ return !items.empty() || closed; });
+        if (items.empty())
+            return false;
+        item = std::move(items.front());
+        items.pop_front();
+        lock.unlock();
+        not_full.notify_one();
+        return true;
+    }
+
+    // Signal that no more items will be pushed.
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+
+private:
+    size_t const capacity;
+    bool closed{0};
+    std::deque<T> items;
+    std::mutex mutex;
+    std::condition_variable not_empty, not_full;
+};
+
+} // namespace priset
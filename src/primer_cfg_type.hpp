@@ -8,7 +8,10 @@
 
 #pragma once
 
+#include <stdexcept>
+#include <string>
 #include <unordered_map>
+#include <utility>
 
 #include <seqan/basic.h>
 
@@ -30,13 +33,13 @@ namespace priset
 // Mask selection, i.e. 10 leading bits and rest 0 or ~(1 << 54) - 1)
 #define PREFIX_SELECTOR 18428729675200069632ULL
 
-// The minimal primer length (or a kmer). Recommended: 18.
+// The minimal primer length (or a kmer) encodable in a kmerID prefix. Recommended: 18.
 #define PRIMER_MIN_LEN 16ULL
 
-// The maximal primer length (or a kmer). Recommended: 22.
+// The maximal primer length (or a kmer) encodable in a kmerID prefix. Recommended: 22.
 #define PRIMER_MAX_LEN 25ULL
 
-/* Primer Verification */
+/* Primer Verification, defaults of the run time settings in primer_cfg_type and io_cfg_type */
 
 // The minimal transcript length.
 #define TRANSCRIPT_MIN_LEN 60
@@ -69,6 +72,29 @@ namespace priset
 // Lower kmer pair frequency cutoff, i.e. all pair occurences below will be dropped.
 #define FREQ_PAIR_MIN_PERCENT 1
 
+/*
+ * Primer length range [MIN_LEN, MAX_LEN] within [PRIMER_MIN_LEN, PRIMER_MAX_LEN]
+ * known at compile time. Hot kernels are templated on it, see primer_length_apply.
+ */
+template<uint64_t MIN_LEN_, uint64_t MAX_LEN_>
+struct TPrimerLengths
+{
+    static_assert(PRIMER_MIN_LEN <= MIN_LEN_ && MIN_LEN_ <= MAX_LEN_ && MAX_LEN_ <= PRIMER_MAX_LEN,
+                  "Primer length range exceeds kmerID prefix.");
+
+    static constexpr uint64_t MIN_LEN = MIN_LEN_;
+    static constexpr uint64_t MAX_LEN = MAX_LEN_;
+
+    // Length bits of MIN_LEN and MAX_LEN in a kmerID prefix.
+    static constexpr uint64_t MIN_LEN_BIT = ONE_LSHIFT_63 >> (MIN_LEN - PRIMER_MIN_LEN);
+    static constexpr uint64_t MAX_LEN_BIT = ONE_LSHIFT_63 >> (MAX_LEN - PRIMER_MIN_LEN);
+
+    // Length bits of all lengths in range, the shift wraps around for MIN_LEN = PRIMER_MIN_LEN.
+    static constexpr uint64_t SELECTOR = (MIN_LEN_BIT << 1) - MAX_LEN_BIT;
+};
+
+using TPrimerLengthsFull = TPrimerLengths<PRIMER_MIN_LEN, PRIMER_MAX_LEN>;
+
 
 struct primer_cfg_type
 {
@@ -94,6 +120,29 @@ private:
     // Number of positions varying from kmer sequence, i.e. number of permitted primer errors.
     size_type E{0};
 
+    // Number of 3' bases matching exactly in approximate k-mer matches, 0 for uniform mismatch positions.
+    size_type anchor{0};
+
+    // Primer length range, a subrange of [PRIMER_MIN_LEN, PRIMER_MAX_LEN].
+    size_type primer_min_len{PRIMER_MIN_LEN};
+    size_type primer_max_len{PRIMER_MAX_LEN};
+
+    // Transcript length range.
+    size_type transcript_min_len{TRANSCRIPT_MIN_LEN};
+    size_type transcript_max_len{TRANSCRIPT_MAX_LEN};
+
+    // Primer melting temperature range and maximal difference of paired primers.
+    size_type primer_min_Tm{PRIMER_MIN_TM};
+    size_type primer_max_Tm{PRIMER_MAX_TM};
+    size_type primer_dTm{PRIMER_DTM};
+
+    // Relative CG content range, kept in double precision like the default literals.
+    double CG_min_content{CG_MIN_CONTENT};
+    double CG_max_content{CG_MAX_CONTENT};
+
+    // Minimal distance (bp) between two identical kmers on same reference.
+    size_type trap_dist{TRAP_DIST};
+
 public:
     // Constructors, destructor and assignment
     // Default constructor.
@@ -144,6 +193,140 @@ public:
     {
         return E;
     }
+
+    // Set number of 3' bases of forward primers that have to match exactly, mismatches
+    // are permitted only 5' of them. Throws std::invalid_argument if anchor_ exceeds
+    // the minimal primer length.
+    void set_anchor(size_type anchor_)
+    {
+        if (anchor_ > primer_min_len)
+            throw std::invalid_argument("ERROR: anchor " + std::to_string(anchor_) + " exceeds minimal primer length " + std::to_string(primer_min_len));
+        anchor = anchor_;
+    }
+
+    // Get number of exactly matching 3' bases.
+    size_type get_anchor() const noexcept
+    {
+        return anchor;
+    }
+
+    // Set primer length range, throws std::invalid_argument if not within [PRIMER_MIN_LEN, PRIMER_MAX_LEN].
+    void set_primer_length(size_type min_len, size_type max_len)
+    {
+        if (min_len < PRIMER_MIN_LEN || min_len > max_len || max_len > PRIMER_MAX_LEN)
+            throw std::invalid_argument("ERROR: primer length range [" + std::to_string(min_len) + ":" +
+                std::to_string(max_len) + "] not within [" + std::to_string(PRIMER_MIN_LEN) + ":" + std::to_string(PRIMER_MAX_LEN) + "]");
+        primer_min_len = min_len;
+        primer_max_len = max_len;
+    }
+
+    size_type get_primer_min_len() const noexcept
+    {
+        return primer_min_len;
+    }
+
+    size_type get_primer_max_len() const noexcept
+    {
+        return primer_max_len;
+    }
+
+    // Set transcript length range, throws std::invalid_argument for an empty range.
+    void set_transcript_length(size_type min_len, size_type max_len)
+    {
+        if (min_len > max_len)
+            throw std::invalid_argument("ERROR: empty transcript length range");
+        transcript_min_len = min_len;
+        transcript_max_len = max_len;
+    }
+
+    size_type get_transcript_min_len() const noexcept
+    {
+        return transcript_min_len;
+    }
+
+    size_type get_transcript_max_len() const noexcept
+    {
+        return transcript_max_len;
+    }
+
+    // Set melting temperature range, throws std::invalid_argument for an empty range.
+    void set_Tm(size_type min_Tm, size_type max_Tm)
+    {
+        if (min_Tm > max_Tm)
+            throw std::invalid_argument("ERROR: empty melting temperature range");
+        primer_min_Tm = min_Tm;
+        primer_max_Tm = max_Tm;
+    }
+
+    size_type get_min_Tm() const noexcept
+    {
+        return primer_min_Tm;
+    }
+
+    size_type get_max_Tm() const noexcept
+    {
+        return primer_max_Tm;
+    }
+
+    // Set maximal melting temperature difference of paired primers.
+    void set_dTm(size_type dTm)
+    {
+        primer_dTm = dTm;
+    }
+
+    size_type get_dTm() const noexcept
+    {
+        return primer_dTm;
+    }
+
+    // Set relative CG content range, throws std::invalid_argument if not within [0, 1].
+    void set_CG_content(double min_content, double max_content)
+    {
+        if (min_content < 0 || min_content > max_content || max_content > 1)
+            throw std::invalid_argument("ERROR: CG content range not within [0, 1]");
+        CG_min_content = min_content;
+        CG_max_content = max_content;
+    }
+
+    double get_CG_min_content() const noexcept
+    {
+        return CG_min_content;
+    }
+
+    double get_CG_max_content() const noexcept
+    {
+        return CG_max_content;
+    }
+
+    // Set minimal distance between two identical kmers on same reference.
+    void set_trap_dist(size_type dist)
+    {
+        trap_dist = dist;
+    }
+
+    size_type get_trap_dist() const noexcept
+    {
+        return trap_dist;
+    }
 };
 
+/*
+ * Call f(TPrimerLengths<MIN_LEN, MAX_LEN>{}) with the primer length range of primer_cfg.
+ * Templates are instantiated for the ranges [16:25] (default), [18:22] (recommended),
+ * [16:22] and [18:25]. Other ranges get the kernels of the full range, which give
+ * the same result since kmerIDs carry no length bits outside the configured range.
+ */
+template<typename TFunc>
+decltype(auto) primer_length_apply(primer_cfg_type const & primer_cfg, TFunc && f)
+{
+    auto const range = std::make_pair(primer_cfg.get_primer_min_len(), primer_cfg.get_primer_max_len());
+    if (range == std::make_pair(18U, 22U))
+        return f(TPrimerLengths<18, 22>{});
+    if (range == std::make_pair(16U, 22U))
+        return f(TPrimerLengths<16, 22>{});
+    if (range == std::make_pair(18U, 25U))
+        return f(TPrimerLengths<18, 25>{});
+    return f(TPrimerLengthsFull{});
+}
+
 }  // namespace priset
@@ -0,0 +1,134 @@
+// ============================================================================
+//                    PriSeT - The Primer Search Tool
+// ============================================================================
+//          Author: Marie Hoffmann <marie.hoffmann AT fu-berlin.de>
+//          Manual: https://github.com/mariehoffmann/PriSeT
+
+// Search schemes for approximate k-mer matching in bidirectional FM indices.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <seqan/index.h>
+
+namespace priset
+{
+
+/*
+ * A search of a search scheme (Kucherov et al. 2016, Kianfar et al. 2018). The
+ * pattern is split into equally sized parts which are matched in the order given
+ * by pi (1-based, each part adjacent to the ones matched before). After matching
+ * the i-th part of pi the accumulated number of mismatches is in [L[i], U[i]].
+ */
+struct TSearch
+{
+    std::vector<uint8_t> pi;
+    std::vector<uint8_t> L;
+    std::vector<uint8_t> U;
+};
+
+using TSearchScheme = std::vector<TSearch>;
+
+/*
+ * Return the optimum search scheme for E in [1:3] mismatches with E + 1 parts. Every
+ * distribution of at most E mismatches over the parts is covered by exactly one
+ * search, hence each approximate match is found once. For other E an empty scheme
+ * is returned.
+ */
+inline TSearchScheme const & search_scheme(uint8_t const E)
+{
+    static std::vector<TSearchScheme> const schemes{
+        {},
+        {{{1, 2}, {0, 0}, {0, 1}},
+         {{2, 1}, {0, 1}, {0, 1}}},
+        {{{2, 1, 3}, {0, 0, 0}, {0, 1, 2}},
+         {{1, 2, 3}, {0, 1, 1}, {0, 2, 2}},
+         {{3, 2, 1}, {0, 0, 2}, {0, 1, 2}}},
+        {{{1, 2, 3, 4}, {0, 0, 0, 0}, {0, 0, 3, 3}},
+         {{3, 2, 1, 4}, {0, 0, 1, 1}, {0, 2, 2, 3}},
+         {{1, 2, 3, 4}, {0, 1, 2, 2}, {1, 1, 2, 3}},
+         {{4, 3, 2, 1}, {0, 0, 0, 3}, {0, 2, 3, 3}}}};
+    return E < schemes.size() ? schemes[E] : schemes[0];
+}
+
+// A single character step of a search: pattern position, extension direction and mismatch bounds.
+struct TSearchStep
+{
+    uint8_t pos;
+    bool right;
+    uint8_t L;
+    uint8_t U;
+};
+
+using TSearchSteps = std::vector<TSearchStep>;
+
+/*
+ * Unroll the searches of a scheme into character steps for a pattern of length m.
+ * The lower bound of a part is only checked at its last character.
+ */
+inline std::vector<TSearchSteps> search_scheme_steps(TSearchScheme const & scheme, uint8_t const m)
+{
+    std::vector<TSearchSteps> steps_per_search;
+    for (TSearch const & search : scheme)
+    {
+        uint8_t const parts = search.pi.size();
+        std::vector<uint8_t> begin(parts + 1, 0);
+        for (uint8_t p = 0; p < parts; ++p)
+            begin[p + 1] = begin[p] + m / parts + (p < m % parts);
+        TSearchSteps steps;
+        uint8_t part_max = search.pi[0];
+        for (uint8_t i = 0; i < parts; ++i)
+        {
+            uint8_t const part = search.pi[i];
+            // the first part is matched in the direction of the second one
+            bool const right = i ? part > part_max : (parts == 1 || search.pi[1] > part);
+            part_max = std::max(part_max, part);
+            uint8_t const len = begin[part] - begin[part - 1];
+            for (uint8_t k = 0; k < len; ++k)
+            {
+                uint8_t const pos = right ? begin[part - 1] + k : begin[part] - 1 - k;
+                steps.push_back(TSearchStep{pos, right, uint8_t(k + 1 == len ? search.L[i] : 0), search.U[i]});
+            }
+        }
+        steps_per_search.push_back(steps);
+    }
+    return steps_per_search;
+}
+
+// Match pattern from step j on, report(it, errors) is called for each match.
+template<typename TIter, typename TReport>
+void search_scheme_step(TIter const & it, std::string const & pattern, TSearchSteps const & steps, uint8_t const j, uint8_t const errors, TReport && report)
+{
+    if (j == steps.size())
+    {
+        report(it, errors);
+        return;
+    }
+    TSearchStep const & step = steps[j];
+    for (char const c : {'A', 'C', 'G', 'T'})
+    {
+        uint8_t const errors_next = errors + (c != pattern[step.pos]);
+        if (errors_next > step.U || errors_next < step.L)
+            continue;
+        TIter it_next = it;
+        if (step.right ? seqan::goDown(it_next, seqan::Dna(c), seqan::Rev()) : seqan::goDown(it_next, seqan::Dna(c), seqan::Fwd()))
+            search_scheme_step(it_next, pattern, steps, j + 1, errors_next, report);
+    }
+}
+
+/*
+ * Find all matches of pattern with Hamming distance bounded by the unrolled search
+ * scheme, starting from the root iterator of a bidirectional index.
+ */
+template<typename TIter, typename TReport>
+void search_scheme(TIter const & root, std::string const & pattern, std::vector<TSearchSteps> const & steps_per_search, TReport && report)
+{
+    for (TSearchSteps const & steps : steps_per_search)
+        search_scheme_step(root, pattern, steps, 0, 0, report);
+}
+
+} // namespace priset
@@ -10,12 +10,15 @@
 
 #include <bitset>
 #include <stdlib.h>
+#include <vector>
 
 //#include <sdsl/bit_vectors.hpp>
 #include "../submodules/sdsl-lite/include/sdsl/bit_vectors.hpp"
 
 #include "../submodules/genmap/src/common.hpp"
 
+#include "parallel.hpp"
+
 //#include "primer_cfg_type.hpp"
 
 #define ONE_LSHIFT_63 9223372036854775808ULL
@@ -50,11 +53,78 @@ using TSeqPos = uint64_t;
 // Kmer length type. A negative indicates reverse direction given associated position.
 using TKmerLength = int64_t;
 using TBWTLen = uint64_t;
-using TFMIndexConfig = TGenMapFastFMIndexConfig<TBWTLen>;
+
+/*
+ * FM index flavour with BWT length type TBWTLen_ and suffix array sampling rate
+ * SAMPLING_. A 32 bit TBWTLen_ shrinks the rank dictionary counters and fits texts
+ * (including sentinels) shorter than 2^32, a sparser sampling shrinks the suffix
+ * arrays at the cost of slower locate. Rank dictionaries are those of genmap's fast config.
+ */
+template<typename TBWTLen_, unsigned SAMPLING_>
+struct TFMIndexConfigFlavour
+{
+    using LengthSum = TBWTLen_;
+    using Bwt = typename TGenMapFastFMIndexConfig<TBWTLen_>::Bwt;
+    using Sentinels = typename TGenMapFastFMIndexConfig<TBWTLen_>::Sentinels;
+    static const unsigned SAMPLING = SAMPLING_;
+};
+
+// Default flavour with 64 bit BWT length and genmap's sampling rate.
+using TFMIndexConfig = TFMIndexConfigFlavour<TBWTLen, TGenMapFastFMIndexConfig<TBWTLen>::SAMPLING>;
 typedef seqan::String<seqan::Dna, seqan::Alloc<>> TString;
 typedef seqan::StringSet<TString, seqan::Owner<seqan::ConcatDirect<SizeSpec_<TSeqNo, TSeqPos> > > > TStringSet;
-// set index type, TBiIndexConfig defined src/common.hpp
-using TIndex = seqan::Index<TStringSet, TBiIndexConfig<TFMIndexConfig> >;
+
+// Rebind the fibre specialization of a rank dictionary to memory-mapped strings.
+template<typename TRankDictionary>
+struct TMMapRankDictionary;
+
+template<typename TValue, typename TSize, typename TFibre, unsigned LEVELS, unsigned WORDS_PER_BLOCK>
+struct TMMapRankDictionary<seqan::Levels<TValue, seqan::LevelsPrefixRDConfig<TSize, TFibre, LEVELS, WORDS_PER_BLOCK> > >
+{
+    using Type = seqan::Levels<TValue, seqan::LevelsPrefixRDConfig<TSize, seqan::MMap<>, LEVELS, WORDS_PER_BLOCK> >;
+};
+
+template<typename TValue, typename TSize, typename TFibre, unsigned LEVELS, unsigned WORDS_PER_BLOCK>
+struct TMMapRankDictionary<seqan::Levels<TValue, seqan::LevelsRDConfig<TSize, TFibre, LEVELS, WORDS_PER_BLOCK> > >
+{
+    using Type = seqan::Levels<TValue, seqan::LevelsRDConfig<TSize, seqan::MMap<>, LEVELS, WORDS_PER_BLOCK> >;
+};
+
+// FM index configuration equal to TConfig, but with all fibres memory-mapped
+// read-only from the index files instead of being copied onto the heap. Files are
+// the same, hence an index built once can be opened in both modes.
+template<typename TConfig>
+struct TFMIndexConfigMMapOf
+{
+    using LengthSum = typename TConfig::LengthSum;
+    using Bwt = typename TMMapRankDictionary<typename TConfig::Bwt>::Type;
+    using Sentinels = typename TMMapRankDictionary<typename TConfig::Sentinels>::Type;
+    static const unsigned SAMPLING = TConfig::SAMPLING;
+};
+using TFMIndexConfigMMap = TFMIndexConfigMMapOf<TFMIndexConfig>;
+// Memory-mapped text corpus. The suffix array values inherit the MMap string
+// specialization from the text (see seqan::DefaultIndexStringSpec).
+typedef seqan::String<seqan::Dna, seqan::MMap<> > TStringMMap;
+typedef seqan::StringSet<TStringMMap, seqan::Owner<seqan::ConcatDirect<SizeSpec_<TSeqNo, TSeqPos> > > > TStringSetMMap;
+
+// Bidirectional FM index types of a flavour, TBiIndexConfig defined src/common.hpp
+template<typename TConfig>
+using TIndexOf = seqan::Index<TStringSet, TBiIndexConfig<TConfig> >;
+template<typename TConfig>
+using TIndexMMapOf = seqan::Index<TStringSetMMap, TBiIndexConfig<TFMIndexConfigMMapOf<TConfig> > >;
+// set index type of default flavour
+using TIndex = TIndexOf<TFMIndexConfig>;
+using TIndexMMap = TIndexMMapOf<TFMIndexConfig>;
+
+// FM index configuration of an index type.
+template<typename TFMIndex>
+struct TFMIndexConfigOf;
+
+template<typename TText, typename TConfig>
+struct TFMIndexConfigOf<seqan::Index<TText, TBiIndexConfig<TConfig> > >
+{
+    using Type = TConfig;
+};
 
 typedef seqan::String<priset::dna> TSeq;
 
@@ -69,11 +139,18 @@ typedef std::map<TLocation,
 // A k-mer location augmented by the information about K.
 typedef std::tuple<priset::TSeqNo, priset::TSeqPos, priset::TKmerLength> TKLocation;
 
-// The map of k-mer locations augmented by K information to preserve key uniqueness.
-// Contains mappings for all values of K in range (see primer_cfg_type.hpp).
-typedef std::map<TKLocation,
-        std::pair<std::vector<TLocation >,
-                  std::vector<TLocation > > > TKLocations;
+// The store of k-mer locations augmented by K, TKLocations, is defined in location_store.hpp.
+
+// Locations of a frequent k-mer of length K and of its approximate matches in
+// lexicographical order, as passed by the mapper to a streaming consumer.
+struct TLocationGroup
+{
+    TKmerLength K;
+    std::vector<TLocation> locations;
+};
+
+// Bounded queue between mapper and filter, see fm_map and filter_and_transform.
+using TLocationQueue = bounded_queue<TLocationGroup>;
 
 //
 using TDirectoryInformation = typename seqan::StringSet<seqan::CharString, seqan::Owner<seqan::ConcatDirect<> > > ;
@@ -98,19 +175,62 @@ typedef uint64_t TAccID;
 // The type of an accession
 typedef std::string TAcc;
 
-// A bit vector for each reference, with 1 indicating a kmer starting position.
-typedef sdsl::bit_vector TReference;
-typedef std::vector<TReference> TReferences;
-
-// Stores for each reference the encoded kmers in order of occurrence.
-typedef std::vector<std::deque<TKmerID>> TKmerIDs;
+// The store of encoded kmers per reference in order of occurrence, TKmerIDs, is defined in kmer_id_store.hpp.
 
 // Translates sequences identifiers (seqNo) in use to a contiguous range (seqNo_cx).
-// Dictionary is bidirectional: seqNo -> seqNo_cx and inverse add a leading one
-// to the compressed key: (1 << 63 | seqNo_cx) -> seqNo.
+// Dictionary is bidirectional with a dense array in each direction, seqNos are
+// assigned increasing compressed identifiers in the order they are added.
 // Background: some sequences produce no k-mers and therefore no space should be
 // reserved in its bit transformation.
-typedef std::unordered_map<TSeqNo, TSeqNo> TSeqNoMap;
+class TSeqNoMap
+{
+public:
+    // Compressed identifier of sequences not in use.
+    static constexpr TSeqNo NO_SEQNO_CX = ~0ULL;
+
+    TSeqNoMap() = default;
+
+    // Remove all sequence identifiers.
+    void clear() noexcept
+    {
+        seqNos.clear();
+        seqNo_cxs.clear();
+    }
+
+    // Assign the next compressed identifier to seqNo and return it.
+    TSeqNo push_back(TSeqNo const seqNo)
+    {
+        if (seqNo >= seqNo_cxs.size())
+            seqNo_cxs.resize(seqNo + 1, NO_SEQNO_CX);
+        seqNo_cxs[seqNo] = seqNos.size();
+        seqNos.push_back(seqNo);
+        return seqNos.size() - 1;
+    }
+
+    // Number of sequence identifiers in use.
+    uint64_t size() const noexcept
+    {
+        return seqNos.size();
+    }
+
+    // Return seqNo of compressed identifier seqNo_cx.
+    TSeqNo seqNo(TSeqNo const seqNo_cx) const noexcept
+    {
+        return seqNos[seqNo_cx];
+    }
+
+    // Return compressed identifier of seqNo or NO_SEQNO_CX if not in use.
+    TSeqNo seqNo_cx(TSeqNo const seqNo) const noexcept
+    {
+        return seqNo < seqNo_cxs.size() ? seqNo_cxs[seqNo] : NO_SEQNO_CX;
+    }
+
+private:
+    // seqNo_cx -> seqNo
+    std::vector<TSeqNo> seqNos;
+    // seqNo -> seqNo_cx
+    std::vector<TSeqNo> seqNo_cxs;
+};
 
 // vector type of k-mers and their locations
 struct TKmerLocation
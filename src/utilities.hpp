@@ -25,6 +25,7 @@
 #include "chemistry.hpp"
 #include "combine_types.hpp"
 #include "io_cfg_type.hpp"
+#include "kmer_id_store.hpp"
 #include "types.hpp"
 
 // Split prefix and code given a kmerID.
@@ -248,8 +249,8 @@ void print_combinations(TKmerIDs const & kmerIDs, TPairList const & pairs) noexc
     std::cout << "pairs.size = " << pairs.size() << std::endl;
     for (auto pair : pairs)
     {
-        TKmerID kmerID_fwd = kmerIDs.at(pair.reference).at(pair.r_fwd - 1);
-        TKmerID kmerID_rev = kmerIDs.at(pair.reference).at(pair.r_rev - 1);
+        TKmerID kmerID_fwd = kmerIDs.at(pair.reference, pair.r_fwd - 1);
+        TKmerID kmerID_rev = kmerIDs.at(pair.reference, pair.r_rev - 1);
         std::cout << pair.reference << "\t | " << kmerID_fwd << "\t | " << kmerID_rev << "\t| ";
         std::vector<std::pair<uint8_t, uint8_t>> combinations;
         pair.cp.get_combinations(combinations);
@@ -513,23 +514,20 @@ void accumulation_loop(TKmerContainer const & kmer_container, std::vector<std::p
 template<typename TKmerIDs>
 void unique_kmers(TKmerIDs const & kmerIDs, std::set<uint64_t> & set)
 {
-    for (auto it_ref = kmerIDs.begin(); it_ref < kmerIDs.end(); ++it_ref)
+    for (auto it_kmerID = kmerIDs.begin(); it_kmerID != kmerIDs.end(); ++it_kmerID)
     {
-        for (auto it_kmerID = it_ref->begin(); it_kmerID <= it_ref->end(); ++it_kmerID)
+        auto [prefix, code] = split_kmerID(*it_kmerID);
+        bool start_shift = false; // since kmer IDs represent only the longest kmer they encode and not necessarily the longest possible primer length, we start truncating the ID after we have seen the first length bit
+        while (prefix)
         {
-            auto [prefix, code] = split_kmerID(*it_kmerID);
-            bool start_shift = false; // since kmer IDs represent only the longest kmer they encode and not necessarily the longest possible primer length, we start truncating the ID after we have seen the first length bit
-            while (prefix)
+            if (prefix & 1)
             {
-                if (prefix & 1)
-                {
-                    start_shift = true;
-                    set.insert(code);
-                }
-                prefix >>= 1;
-                if (start_shift)
-                    code >>= 2;
+                start_shift = true;
+                set.insert(code);
             }
+            prefix >>= 1;
+            if (start_shift)
+                code >>= 2;
         }
     }
 }
@@ -538,11 +536,8 @@ void unique_kmers(TKmerIDs const & kmerIDs, std::set<uint64_t> & set)
 uint64_t get_num_kmers(TKmerIDs const & kmerIDs)
 {
     uint64_t ctr = 0;
-    for (auto kmerIDs_per_reference : kmerIDs)
-    {
-        for (auto kmerID : kmerIDs_per_reference)
-            ctr += __builtin_popcountll(kmerID >> 54);
-    }
+    for (TKmerID const kmerID : kmerIDs)
+        ctr += __builtin_popcountll(kmerID >> 54);
     return ctr;
 }
 
@@ -573,8 +568,8 @@ void unique_pairs(TPairList const & pairs, TKmerIDs const & kmerIDs, std::unorde
         uint64_t code_fwd, code_rev;
         for (std::pair<TKmerLength, TKmerLength> c : combinations)
         {
-            code_fwd = get_code(kmerIDs.at(pair.reference).at(pair.r_fwd - 1), ONE_LSHIFT_63 >> c.first);
-            code_rev = get_code(kmerIDs.at(pair.reference).at(pair.r_rev - 1), ONE_LSHIFT_63 >> c.second);
+            code_fwd = get_code(kmerIDs.at(pair.reference, pair.r_fwd - 1), ONE_LSHIFT_63 >> c.first);
+            code_rev = get_code(kmerIDs.at(pair.reference, pair.r_rev - 1), ONE_LSHIFT_63 >> c.second);
             uint64_t key = hash_pair(code_fwd, code_rev);
             if (code_pairs.find(key) != code_pairs.end())
                 ++code_pairs[key];
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <experimental/filesystem>
 #include <fstream>
+#include <random>
 #include <regex>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -297,12 +298,49 @@ void test_filter_cross_annealing_disconnected()
         std::cout << "OK\n";
 }
 
+// Pairs without complementary 4-mers must not be changed by filter_cross_annealing.
+void test_cross_annealing_candidate()
+{
+    // TTTT is reverse complementary to AAAA
+    TKmerAttributes const attributes1 = kmer_attributes((1ULL << 63) | dna_encoder("CGAAAAGTCAGGGGACG"));
+    TKmerAttributes const attributes2 = kmer_attributes((1ULL << 63) | dna_encoder("CTTTTCGCGCGCGCGC"));
+    if (!cross_annealing_candidate(attributes1, attributes2))
+        std::cout << "ERROR: expected shared 4-mer to be detected\n";
+    else
+        std::cout << "OK\n";
+
+    std::mt19937_64 generator(0);
+    auto random_kmerID = [&generator]()
+    {
+        uint64_t const l = PRIMER_MIN_LEN + generator() % PREFIX_SIZE;
+        uint64_t const code = (1ULL << (l << 1)) | (generator() & ((1ULL << (l << 1)) - 1));
+        return (PREFIX_SELECTOR & (~0ULL << (WORD_SIZE - 1 - (l - PRIMER_MIN_LEN)))) | code;
+    };
+    for (uint64_t i = 0; i < 100000; ++i)
+    {
+        TKmerID kmerID1 = random_kmerID();
+        TKmerID kmerID2 = random_kmerID();
+        if (cross_annealing_candidate(kmer_attributes(kmerID1), kmer_attributes(kmerID2)))
+            continue;
+        TKmerID const kmerID1_before = kmerID1;
+        TKmerID const kmerID2_before = kmerID2;
+        filter_cross_annealing(kmerID1, kmerID2);
+        if (kmerID1 != kmerID1_before || kmerID2 != kmerID2_before)
+        {
+            std::cout << "ERROR: cross-annealing of " << kmerID1_before << " and " << kmerID2_before << " not detected by 4-mer sets\n";
+            return;
+        }
+    }
+    std::cout << "OK\n";
+}
+
 int main()
 {
     test_filter_self_annealing_connected();
     test_filter_cross_annealing_connected();
     test_filter_self_annealing_disconnected();
     test_filter_cross_annealing_disconnected();
+    test_cross_annealing_candidate();
 
     return 0;
 }
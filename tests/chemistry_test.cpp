@@ -1,8 +1,10 @@
 #include <cassert>
 #include <chrono>
+#include <cstdlib>
 #include <iostream>
 #include <experimental/filesystem>
 #include <fstream>
+#include <random>
 #include <regex>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -155,6 +157,244 @@ void filter_repeats_runs_test()
         std::cout << "INFO: Success, 5TAs filtered\n";
 }
 
+/*
+ * Filter of runs and di-nucleotide repeats scanning the code base by base as
+ * filter_repeats_runs did before it became word-parallel, used as reference.
+ */
+void filter_repeats_runs_loop(TKmerID & kmerID)
+{
+    auto [prefix, code] = split_kmerID(kmerID);
+    if (!prefix)
+        return;
+    uint64_t const tail_selector_10 = (1 << 10) - 1;
+    uint64_t const tail_selector_20 = (1 << 20) - 1;
+    kmerID = code;
+    uint64_t k = encoded_length(code);
+    while (code >= (1 << 10))
+    {
+        uint64_t const tail_10 = tail_selector_10 & code;
+        // A_5, C_5, G_5, T_5
+        if ((tail_10 == 0b0000000000) || (tail_10 == 0b0101010101) || (tail_10 == 0b1010101010) || (tail_10 == 0b1111111111))
+            prefix = erase_bits(prefix, k);
+        if (code >= (1ULL << 20))
+        {
+            uint64_t const tail_20 = code & tail_selector_20;
+            // AT_5, TA_5, AC_5, CA_5, AG_5, GA_5, CG_5, GC_5, CT_5, TC_5, GT_5, TG_5
+            if ( (tail_20 == 0b00110011001100110011) || (tail_20 == 0b11001100110011001100) ||
+                 (tail_20 == 0b00010001000100010001) || (tail_20 == 0b01000100010001000100) ||
+                 (tail_20 == 0b00100010001000100010) || (tail_20 == 0b10001000100010001000) ||
+                 (tail_20 == 0b01100110011001100110) || (tail_20 == 0b10011001100110011001) ||
+                 (tail_20 == 0b01110111011101110111) || (tail_20 == 0b11011101110111011101) ||
+                 (tail_20 == 0b10111011101110111011) || (tail_20 == 0b11101110111011101110))
+                prefix = erase_bits(prefix, k);
+        }
+        if (!prefix)
+            break;
+        k -= 2;
+        code >>= 2;
+    }
+    kmerID |= prefix;
+}
+
+/*
+ * Random kmerID of length [PRIMER_MIN_LEN:PRIMER_MAX_LEN] with a random subset of
+ * length bits. Runs and di-nucleotide repeats are planted by copying the base 1 or
+ * 2 positions before, or the code is drawn from A and T only.
+ */
+TKmerID random_kmerID(std::mt19937_64 & generator)
+{
+    uint64_t const K = PRIMER_MIN_LEN + generator() % (PRIMER_MAX_LEN - PRIMER_MIN_LEN + 1);
+    uint64_t const mode = generator() % 4;
+    uint64_t code = 1;
+    for (uint64_t i = 0; i < K; ++i)
+    {
+        uint64_t c = generator() & 3;
+        if (mode == 3)
+            c = (c & 1) ? 3 : 0;
+        else if (mode && i >= mode && generator() % 4)
+            c = (code >> ((mode - 1) << 1)) & 3;
+        code = (code << 2) | c;
+    }
+    // only lengths up to K
+    uint64_t prefix = generator() & PREFIX_SELECTOR & ~((ONE_LSHIFT_63 >> (K - PRIMER_MIN_LEN)) - 1);
+    if (!prefix)
+        prefix = ONE_LSHIFT_63 >> (K - PRIMER_MIN_LEN);
+    return prefix | code;
+}
+
+// Word-parallel filter_repeats_runs has to equal the loop above on random kmers.
+bool filter_repeats_runs_loop_test()
+{
+    std::mt19937_64 generator(42);
+    for (uint64_t i = 0; i < 1000000; ++i)
+    {
+        TKmerID const kmerID = random_kmerID(generator);
+        TKmerID kmerID_loop = kmerID;
+        TKmerID kmerID_words = kmerID;
+        filter_repeats_runs_loop(kmerID_loop);
+        filter_repeats_runs(kmerID_words);
+        if (kmerID_loop != kmerID_words)
+        {
+            std::cout << "ERROR: " << kmerID2str(kmerID) << " filtered to " << kmerID2str(kmerID_words) << ", expect " << kmerID2str(kmerID_loop) << std::endl;
+            return false;
+        }
+    }
+    std::cout << "INFO: Success, filter_repeats_runs equals the base by base loop\n";
+    return true;
+}
+
+// TATA and ATAT at the start, in the middle and at the end of a kmer of length 20.
+bool filter_TATA_box_test()
+{
+    TKmerID const prefix = PREFIX_SELECTOR & ~((ONE_LSHIFT_63 >> 4) - 1);
+    // motif ends at base 4, all lengths are dropped
+    // motif ends at base 18, lengths 16 and 17 are kept
+    // motif ends at base 20, only length 20 is dropped
+    std::vector<std::pair<std::string, TKmerID> > const cases{
+        {"TATAACGGCCAGTCGCACGC", 0},
+        {"ACGGCCAGTCGCACATATGC", ONE_LSHIFT_63 | (ONE_LSHIFT_63 >> 1)},
+        {"ACGGCCAGTCGCACGCTATA", prefix & ~(ONE_LSHIFT_63 >> 4)}};
+    for (auto const & [seq, prefix_expected] : cases)
+    {
+        TKmerID kmerID = prefix | dna_encoder(seq);
+        filter_TATA_box(kmerID);
+        if ((kmerID & PREFIX_SELECTOR) != prefix_expected || (kmerID & ~PREFIX_SELECTOR) != dna_encoder(seq))
+        {
+            std::cout << "ERROR: " << seq << " expect length bits " << bits2str(prefix_expected >> 54) << ", got " << bits2str((kmerID & PREFIX_SELECTOR) >> 54) << std::endl;
+            return false;
+        }
+    }
+
+    // compare with a search of the motifs in each length on random kmers
+    std::mt19937_64 generator(42);
+    for (uint64_t i = 0; i < 1000000; ++i)
+    {
+        TKmerID kmerID = random_kmerID(generator);
+        uint64_t const code = kmerID & ~PREFIX_SELECTOR;
+        uint64_t const K = (encoded_length(code)) >> 1;
+        TKmerID prefix_expected = kmerID & PREFIX_SELECTOR;
+        for (uint64_t end = 4; end <= K; ++end)
+        {
+            uint64_t const motif = (code >> ((K - end) << 1)) & 0b11111111;
+            if (motif == 0b11001100 || motif == 0b00110011)
+            {
+                prefix_expected &= (end > PRIMER_MIN_LEN) ? PREFIX_SELECTOR & ~((ONE_LSHIFT_63 >> (end - PRIMER_MIN_LEN - 1)) - 1) : 0;
+                break;
+            }
+        }
+        filter_TATA_box(kmerID);
+        if ((kmerID & PREFIX_SELECTOR) != prefix_expected)
+        {
+            std::cout << "ERROR: " << kmerID2str(prefix_expected | code) << " expected, got " << kmerID2str(kmerID) << std::endl;
+            return false;
+        }
+    }
+    std::cout << "INFO: Success, lengths containing TATA or ATAT dropped\n";
+    return true;
+}
+
+// Lengths of kmerID in TLengths with Tm and CG content of their leading bases in range.
+template<typename TLengths>
+TKmerID filter_Tm_CG_expected(TKmerID const kmerID)
+{
+    uint64_t const code = kmerID & ~PREFIX_SELECTOR;
+    uint64_t const l = (encoded_length(code)) >> 1;
+    TKmerID prefix{0};
+    for (uint64_t K = TLengths::MIN_LEN; K <= std::min<uint64_t>(l, TLengths::MAX_LEN); ++K)
+    {
+        uint64_t const length_bit = ONE_LSHIFT_63 >> (K - PRIMER_MIN_LEN);
+        uint64_t CG{0};
+        for (uint64_t i = 0; i < K; ++i)
+        {
+            uint64_t const c = (code >> ((l - 1 - i) << 1)) & 3;
+            CG += (c == 1 || c == 2);
+        }
+        uint64_t const Tm = ((K - CG) << 1) + (CG << 2);
+        float const CG_content = float(CG) / float(K);
+        if ((kmerID & length_bit) && Tm >= PRIMER_MIN_TM && Tm <= PRIMER_MAX_TM && CG_content >= CG_MIN_CONTENT && CG_content <= CG_MAX_CONTENT)
+            prefix |= length_bit;
+    }
+    return prefix | code;
+}
+
+/*
+ * Tm and CG content are counted per length on its leading bases, also if the TATA
+ * box test dropped the longest lengths. Scalar and AVX2 filters have to agree on
+ * random kmers with partial prefixes, n is not divisible by 4 to run the scalar tail.
+ */
+bool filter_Tm_CG_test()
+{
+    // TATA drops length 20, length 16 has Tm = 50
+    TKmerID kmerID = (PREFIX_SELECTOR & ~((ONE_LSHIFT_63 >> 4) - 1)) | dna_encoder("CTCCAGATGGCCTTAGTATA");
+    TKmerID const prefix_expected = (ONE_LSHIFT_63 >> 1) | (ONE_LSHIFT_63 >> 2) | (ONE_LSHIFT_63 >> 3);
+    filter_TATA_box(kmerID);
+    filter_Tm_CG(kmerID);
+    if ((kmerID & PREFIX_SELECTOR) != prefix_expected)
+    {
+        std::cout << "ERROR: expect length bits " << bits2str(prefix_expected >> 54) << ", got " << bits2str((kmerID & PREFIX_SELECTOR) >> 54) << std::endl;
+        return false;
+    }
+
+    std::mt19937_64 generator(42);
+    uint64_t const n = 1000003;
+    std::vector<TKmerID> kmerIDs(n), kmerIDs_scalar(n), kmerIDs_range(n);
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        kmerIDs[i] = random_kmerID(generator);
+        kmerIDs_scalar[i] = kmerIDs_range[i] = kmerIDs[i];
+        filter_Tm_CG(kmerIDs_scalar[i]);
+        filter_Tm_CG<TPrimerLengths<18, 22> >(kmerIDs_range[i]);
+        if (kmerIDs_scalar[i] != filter_Tm_CG_expected<TPrimerLengthsFull>(kmerIDs[i]) ||
+            kmerIDs_range[i] != filter_Tm_CG_expected<TPrimerLengths<18, 22> >(kmerIDs[i]))
+        {
+            std::cout << "ERROR: " << kmerID2str(kmerIDs[i]) << " filtered to " << kmerID2str(kmerIDs_scalar[i]) << std::endl;
+            return false;
+        }
+    }
+    if (!__builtin_cpu_supports("avx2"))
+    {
+        std::cout << "INFO: AVX2 not supported, skip comparison with filter_Tm_CG_avx2\n";
+        return true;
+    }
+    std::vector<TKmerID> kmerIDs_avx2{kmerIDs}, kmerIDs_avx2_range{kmerIDs};
+    filter_Tm_CG_avx2<TPrimerLengthsFull>(kmerIDs_avx2.data(), n, cg_bounds());
+    filter_Tm_CG_avx2<TPrimerLengths<18, 22> >(kmerIDs_avx2_range.data(), n, cg_bounds());
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        if (kmerIDs_avx2[i] != kmerIDs_scalar[i] || kmerIDs_avx2_range[i] != kmerIDs_range[i])
+        {
+            std::cout << "ERROR: " << kmerID2str(kmerIDs[i]) << " filtered to " << kmerID2str(kmerIDs_avx2[i]) << " by filter_Tm_CG_avx2, expect " << kmerID2str(kmerIDs_scalar[i]) << std::endl;
+            return false;
+        }
+    }
+    std::cout << "INFO: Success, filter_Tm_CG_avx2 equals filter_Tm_CG\n";
+    return true;
+}
+
+// chemical_filter_batch has to equal chemical_filter_single_pass on random kmers.
+bool chemical_filter_batch_test()
+{
+    std::mt19937_64 generator(43);
+    uint64_t const n = 1000003;
+    std::vector<TKmerID> kmerIDs(n), kmerIDs_single(n);
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        kmerIDs[i] = kmerIDs_single[i] = random_kmerID(generator);
+        chemical_filter_single_pass(kmerIDs_single[i]);
+    }
+    chemical_filter_batch(kmerIDs.data(), n);
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        if (kmerIDs[i] != kmerIDs_single[i])
+        {
+            std::cout << "ERROR: chemical_filter_batch yields " << kmerID2str(kmerIDs[i]) << ", expect " << kmerID2str(kmerIDs_single[i]) << std::endl;
+            return false;
+        }
+    }
+    std::cout << "INFO: Success, chemical_filter_batch equals chemical_filter_single_pass\n";
+    return true;
+}
+
 void filter_CG_clamp_test()
 {
     //primer_cfg_type const & primer_cfg{};
@@ -330,5 +570,9 @@ void test3()
 int main()
 {
     filter_CG_clamp_test();
-    return 0;
+    bool success = filter_repeats_runs_loop_test();
+    success &= filter_TATA_box_test();
+    success &= filter_Tm_CG_test();
+    success &= chemical_filter_batch_test();
+    return success ? 0 : EXIT_FAILURE;
 }
@@ -111,37 +111,27 @@ int main(int argc, char ** argv)
     // parse options and init io and primer configurators
     options opt(priset_argc, priset_argv, primer_cfg, io_cfg);
 
-    TKLocations locations;
     TDirectoryInformation directoryInformation;
     TSequenceNames sequenceNames;
     TSequenceLengths sequenceLengths;
 
-    // compute k-mer mappings
-    start = std::chrono::high_resolution_clock::now();
-    fm_map(io_cfg, primer_cfg, locations);
-    finish = std::chrono::high_resolution_clock::now();
-    runtimes.at(TIMEIT::MAP) += std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count();
-
-    std::cout << "INFO: kmers init = " << std::accumulate(locations.begin(), locations.end(), 0, [](unsigned ctr, auto & location){return ctr + location.second.first.size();}) << std::endl;
-
-    TReferences references;
+    // compute k-mer mappings and filter them while mapping, both stages are timed together
     TKmerIDs kmerIDs;
     TSeqNoMap seqNoMap;
     start = std::chrono::high_resolution_clock::now();
-    filter_and_transform(io_cfg, locations, references, seqNoMap, kmerIDs);
+    map_filter_and_transform(io_cfg, primer_cfg, seqNoMap, kmerIDs);
     finish = std::chrono::high_resolution_clock::now();
-    runtimes.at(TIMEIT::FILTER1_TRANSFORM) += std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count();
+    runtimes.at(TIMEIT::MAP) += std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count();
     std::cout << "INFO: kmers after filter1 & transform = " << get_num_kmers(kmerIDs) << std::endl;
 
-    // TODO: delete locations
     using TPairList = TPairList<TPair<TCombinePattern<TKmerID, TKmerLength>>>;
     TPairList pairs;
     // dictionary collecting (unique) pair frequencies
 
     start = std::chrono::high_resolution_clock::now();
     // template<typename TPairList>
-    // void combine(TReferences const & references, TKmerIDs const & kmerIDs, TPairList & pairs, TKmerCounts * kmerCounts = nullptr)
-    combine<TPairList>(references, kmerIDs, pairs, &kmerCounts);
+    // void combine(primer_cfg_type const & primer_cfg, TKmerIDs const & kmerIDs, TPairList & pairs, TKmerCounts * kmerCounts = nullptr, unsigned const threads = 1)
+    combine<TPairList>(primer_cfg, kmerIDs, pairs, &kmerCounts, io_cfg.get_threads());
     finish = std::chrono::high_resolution_clock::now();
     runtimes.at(TIMEIT::COMBINE_FILTER2) += std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count();
 
@@ -149,7 +139,7 @@ int main(int argc, char ** argv)
 
     std::vector<TPairFreq> pair_freqs;
     start = std::chrono::high_resolution_clock::now();
-    filter_pairs<TPairList, TPairFreqList>(io_cfg, references, kmerIDs, pairs, pair_freqs, &kmerCounts);
+    filter_pairs<TPairList, TPairFreqList>(io_cfg, kmerIDs, pairs, pair_freqs, &kmerCounts);
     std::cout << "INFO: pairs after pair_freq filter = " << kmerCounts[KMER_COUNTS::FILTER2_CNT] << std::endl;
     finish = std::chrono::high_resolution_clock::now();
     runtimes.at(TIMEIT::PAIR_FREQ) += std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count();
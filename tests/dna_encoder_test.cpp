@@ -1,8 +1,10 @@
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <iostream>
 #include <experimental/filesystem>
 #include <fstream>
+#include <random>
 #include <regex>
 #include <string>
 #include <sys/wait.h>
@@ -62,8 +64,44 @@ void run()
     std::cout << "SUCCESS\n";
 }
 
+// Encode k-mers of a Dna5 reference with N in transform_reference and compare to dna_encoder.
+void run_N()
+{
+    std::string seq;
+    std::mt19937 generator(42);
+    for (uint64_t i = 0; i < 2000; ++i)
+        seq.push_back((i % 37 == 5) ? 'N' : "ACGT"[generator() % 4]);
+    seqan::Dna5String const sequence(seq);
+
+    // all primer lengths at each position with a complete 25-mer
+    TReferenceMasks masks;
+    for (TSeqPos seqPos = 0; seqPos + PRIMER_MAX_LEN <= seq.size(); ++seqPos)
+        masks.add(seqPos, ((1U << PREFIX_SIZE) - 1) << 1);
+    std::vector<TKmerID> kmerIDs_reference;
+    std::vector<TSeqPos> positions;
+    transform_reference<TPrimerLengthsFull>(sequence, masks, cg_bounds(), kmerIDs_reference, positions);
+    if (kmerIDs_reference.empty())
+    {
+        std::cout << "ERROR: expect kmers passing the filter\n";
+        exit(0);
+    }
+    std::replace(seq.begin(), seq.end(), 'N', 'A');
+    for (uint64_t i = 0; i < kmerIDs_reference.size(); ++i)
+    {
+        uint64_t const code = kmerIDs_reference[i] & ~PREFIX_SELECTOR;
+        uint64_t const expected = dna_encoder(seq.substr(positions[i], (encoded_length(code)) >> 1));
+        if (code != expected)
+        {
+            std::cout << "ERROR: kmer at position " << positions[i] << " expect " << expected << " got " << code << std::endl;
+            exit(0);
+        }
+    }
+    std::cout << "SUCCESS\n";
+}
+
 int main()
 {
     run();
+    run_N();
     return 0;
 }
@@ -39,9 +39,7 @@ struct setup
     io_cfg_type io_cfg{};
     primer_cfg_type primer_cfg{};
     TKLocations locations{};
-    using TLocationPair = std::pair<std::vector<TLocation>, std::vector<TLocation>>;
 
-    TReferences references;
     TKmerIDs kmerIDs;
     TSeqNoMap seqNoMap;
     TSeqNo cutoff = 1;
@@ -77,13 +75,15 @@ struct setup
             std::cout << "arg[" << i << "] = " << argv[i] << std::endl;
         options opt(argc, argv, primer_cfg, io_cfg);
 
-        std::vector<TLocation> loc1{TLocation{0, 10}}, vd{}; // seqan::Pair<TSeqNo, TSeqPos>
-        locations.insert({TKLocation{0, 10, 19}, TLocationPair{loc1, vd}});
-        locations.insert({TKLocation{0, 10, 21}, TLocationPair{loc1, vd}});
-        locations.insert({TKLocation{0, 10, 23}, TLocationPair{loc1, vd}});
+        std::vector<TLocation> loc1{TLocation{0, 10}}; // seqan::Pair<TSeqNo, TSeqPos>
+        locations.reset(io_cfg.get_library_size());
+        locations.append(19, loc1[0], loc1);
+        locations.append(21, loc1[0], loc1);
+        locations.append(23, loc1[0], loc1);
 
         std::vector<TLocation> loc2{TLocation{0, 90}}; // seqan::Pair<TSeqNo, TSeqPos>
-        locations.insert({TKLocation{0, 90, 21}, TLocationPair{loc2, vd}});
+        locations.append(21, loc2[0], loc2);
+        locations.sort();
 
     }
 };
@@ -91,20 +91,20 @@ struct setup
 void test_filter_and_transform()
 {
     setup su{};
-    filter_and_transform(su.io_cfg, su.locations, su.references, su.kmerIDs, su.seqNoMap, su.kmerCounts);
-    std::cout << "References:\n";
-    for (TReference reference : su.references)
+    filter_and_transform(su.io_cfg, su.primer_cfg, su.locations, su.seqNoMap, su.kmerIDs);
+    std::cout << "Positions:\n";
+    for (uint64_t seqNo_cx = 0; seqNo_cx < su.kmerIDs.size(); ++seqNo_cx)
     {
         std::cout << "\t";
-        for (auto bit : reference)
-            std::cout << bit;
+        for (uint64_t i = 0; i < su.kmerIDs.size(seqNo_cx); ++i)
+            std::cout << su.kmerIDs.position(seqNo_cx, i) << " ";
         std::cout << std::endl;
     }
     std::cout << "KmerIDs:\n";
-    for (auto kmerID_list : su.kmerIDs)
+    for (uint64_t seqNo_cx = 0; seqNo_cx < su.kmerIDs.size(); ++seqNo_cx)
     {
-        for (TKmerID kmerID : kmerID_list)
-            std::cout << kmerID << " | ";
+        for (auto it = su.kmerIDs.begin(seqNo_cx); it != su.kmerIDs.end(seqNo_cx); ++it)
+            std::cout << *it << " | ";
         std::cout << std::endl;
     }
 
@@ -115,7 +115,7 @@ void test_filter_and_transform()
     // k = 21: AT = 12, CG = 9, Tm = 24 + 36 = 60, CG_content = .43, no CG clamp
     TKmerID expect2 = dna_encoder("TAGCTAACTACATAGCTACGC") + (ONE_LSHIFT_63 >> 5);
 
-    if (!su.kmerIDs.size() || su.kmerIDs[0].size() != 2 || su.kmerIDs[0][0] != expect1 || su.kmerIDs[0][1] != expect2)
+    if (!su.kmerIDs.size() || su.kmerIDs.size(0) != 2 || su.kmerIDs(0, 0) != expect1 || su.kmerIDs(0, 1) != expect2)
         std::cout << "ERROR: expect kmerID1 = " << expect1 << " and kmerID2 = " << expect2 << ", but got nothing or a wrong kmerID\n";
     else
         std::cout << "SUCCESS: Result as expected!\n";
@@ -124,13 +124,13 @@ void test_filter_and_transform()
 void test_combine()
 {
     setup su{};
-    filter_and_transform(su.io_cfg, su.locations, su.references, su.kmerIDs, su.seqNoMap, su.kmerCounts);
+    filter_and_transform(su.io_cfg, su.primer_cfg, su.locations, su.seqNoMap, su.kmerIDs);
     //using TPair = TPair;
     using TPairList = TPairList<TPair<TCombinePattern<TKmerID, TKmerLength>>>;
     TPairList pairs;
     //std::vector<_Ch_type, std::allocator<_CharT> > >(priset::primer_cfg_type&, priset::TKmerIDs&, priset::TPairList<priset::TPair<priset::TCombinePattern<long long unsigned int, long long int> > >&)'
 //     print_combinations<>(su.primer_cfg, su.kmerIDs, pairs);
-    combine(su.references, su.kmerIDs, pairs, su.kmerCounts);
+    combine(su.primer_cfg, su.kmerIDs, pairs, &su.kmerCounts);
     print_combinations<TPairList>(su.kmerIDs, pairs);
 }
 
@@ -0,0 +1,104 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <experimental/filesystem>
+#include <string>
+#include <vector>
+
+#include <seqan/basic.h>
+
+#include "../src/argument_parser.hpp"
+#include "../src/errors.hpp"
+#include "../src/fm.hpp"
+#include "../src/io_cfg_type.hpp"
+#include "../src/location_store.hpp"
+#include "../src/primer_cfg_type.hpp"
+#include "../src/types.hpp"
+
+namespace fs = std::experimental::filesystem;
+using namespace priset;
+
+// Compare runtimes of FM index mapping and k-mer counting by sorting hash-partitioned
+// positions for E = 0 on one or more libraries. Both engines have to report the same k-mer groups.
+// g++ ../PriSeT/tests/kmer_counter_benchmark.cpp -Wno-write-strings -std=c++17 -Wall -Wextra -lstdc++fs -Wno-unknown-pragmas -pthread -DNDEBUG -O3 -I/Users/troja/include -L/Users/troja/lib -lsdsl -ldivsufsort -o kmer_counter_benchmark
+// ./kmer_counter_benchmark ../PriSeT/tests/library/one_seq ../PriSeT/tests/work/one_seq ../PriSeT/tests/library/with_N ../PriSeT/tests/work/with_N ../PriSeT/tests/library/3041 ../PriSeT/tests/work/3041 ../PriSeT/tests/library/131221 ../PriSeT/tests/work/131221
+
+// Run k-mer mapping with the engine selected in io_cfg and return runtime in ms.
+size_t time_mapping(io_cfg_type const & io_cfg, primer_cfg_type const & primer_cfg, TKLocations & locations)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    fm_map(io_cfg, primer_cfg, locations);
+    auto finish = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(finish - start).count();
+}
+
+// Compare keys and location lists of all k-mer groups.
+bool equal_locations(TKLocations const & lhs, TKLocations const & rhs)
+{
+    if (lhs.size() != rhs.size() || lhs.num_locations() != rhs.num_locations())
+        return false;
+    for (uint64_t i = 0; i < lhs.size(); ++i)
+    {
+        if (lhs.key(i) != rhs.key(i))
+            return false;
+        TLocationRange const locs_lhs = lhs.group_locations(lhs.group(i));
+        TLocationRange const locs_rhs = rhs.group_locations(rhs.group(i));
+        if (locs_lhs.size() != locs_rhs.size())
+            return false;
+        for (uint64_t j = 0; j < locs_lhs.size(); ++j)
+            if (locs_lhs[j] != locs_rhs[j])
+                return false;
+    }
+    return true;
+}
+
+int main(int argc, char ** argv)
+{
+    if (argc < 3 || argc % 2 == 0)
+    {
+        std::cout << "Give pairs of paths to lib and work dirs.\n";
+        exit(-1);
+    }
+
+    bool success = true;
+    std::vector<std::string> rows;
+    for (int arg = 1; arg + 1 < argc; arg += 2)
+    {
+        unsigned const priset_argc = 5;
+        char * const priset_argv[priset_argc] = {"priset", "-l", argv[arg], "-w", argv[arg + 1]};
+
+        io_cfg_type io_cfg{};
+        primer_cfg_type primer_cfg{};
+        options opt(priset_argc, priset_argv, primer_cfg, io_cfg);
+        primer_cfg.set_error(0);
+
+        int ret_code;
+        if ((ret_code = fm_index(io_cfg)))
+        {
+            std::cout << "ERROR: " << ret_code << std::endl;
+            exit(-1);
+        }
+
+        TKLocations locations_fm, locations_count;
+        io_cfg.set_kmer_counting(false);
+        size_t const runtime_fm = time_mapping(io_cfg, primer_cfg, locations_fm);
+        io_cfg.set_kmer_counting(true);
+        size_t const runtime_count = time_mapping(io_cfg, primer_cfg, locations_count);
+        bool const equal = equal_locations(locations_fm, locations_count);
+        success &= equal;
+        rows.push_back(fs::path(argv[arg]).filename().string() + '\t' + std::to_string(runtime_fm) + "\t\t" +
+                       std::to_string(runtime_count) + "\t\t" + std::to_string(locations_fm.size()) + '\t' +
+                       std::to_string(locations_fm.num_locations()) + '\t' + (equal ? "yes" : "no"));
+    }
+
+    std::cout << "library\tFM [ms]\t\tcount [ms]\tgroups\tlocations\tequal\n" << std::string(70, '_') << "\n";
+    for (std::string const & row : rows)
+        std::cout << row << std::endl;
+    if (!success)
+    {
+        std::cout << "ERROR: k-mer counting reports different k-mers than FM index mapping\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "SUCCESS: k-mer counting reports the same k-mers as FM index mapping\n";
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+#include "../src/kmer_counter.hpp"
+#include "../src/location_store.hpp"
+#include "../src/types.hpp"
+
+using namespace priset;
+
+// Check that k-mer counting does not report k-mers spanning an N.
+// g++ ../PriSeT/tests/kmer_counter_test.cpp -std=c++17 -Wall -Wextra -pthread -DNDEBUG -O3 -I/Users/troja/include -L/Users/troja/lib -lsdsl -ldivsufsort -o kmer_counter_test
+
+// Count k-mers of text and return them in a single location store.
+void count(seqan::StringSet<seqan::Dna5String> const & text, unsigned const freq_kmer_min, unsigned const threads, TKLocations & locations)
+{
+    locations.reset(seqan::length(text));
+    std::vector<TKLocations> locations_per_thread(threads, locations);
+    kmer_count_traverse(text, PRIMER_MIN_LEN, PRIMER_MAX_LEN, freq_kmer_min, threads, [&](unsigned const thread_id) -> TKLocations &
+    {
+        return locations_per_thread[thread_id];
+    });
+    for (auto & locations_thread : locations_per_thread)
+        locations.merge(locations_thread);
+    locations.sort();
+}
+
+void test_kmer_counter_N()
+{
+    // With N encoded as ordValue 4 in the rolling window, GN used to be read as TA.
+    std::string const prefix = "ACGTTGCAACGTTGCA";
+    std::string const suffix = "CCATGGACTTGACCAT";
+    seqan::StringSet<seqan::Dna5String> text;
+    seqan::appendValue(text, seqan::Dna5String(prefix + "TA" + suffix));
+    seqan::appendValue(text, seqan::Dna5String(prefix + "GN" + suffix));
+    seqan::appendValue(text, seqan::Dna5String("NNNN" + prefix + "GNNG" + suffix));
+
+    for (unsigned threads : {1, 3})
+    {
+        TKLocations locations;
+        count(text, 2, threads, locations);
+        bool found_prefix = false;
+        for (uint64_t i = 0; i < locations.size(); ++i)
+        {
+            auto const [seqNo, seqPos, K] = locations.key(i);
+            std::string const kmer = std::string(seqan::toCString(seqan::CharString(seqan::infix(text[seqNo], seqPos, seqPos + K))));
+            found_prefix |= (kmer == prefix);
+            if (kmer.find('N') != std::string::npos)
+            {
+                std::cout << "ERROR: reported k-mer " << kmer << " contains N\n";
+                return;
+            }
+            for (TLocation const & loc : locations.group_locations(locations.group(i)))
+            {
+                if (std::string(seqan::toCString(seqan::CharString(seqan::infix(text[seqan::getValueI1(loc)], seqan::getValueI2(loc), seqan::getValueI2(loc) + K)))) != kmer)
+                {
+                    std::cout << "ERROR: location (" << seqan::getValueI1(loc) << ", " << seqan::getValueI2(loc) << ") does not match k-mer " << kmer << std::endl;
+                    return;
+                }
+            }
+        }
+        if (!found_prefix)
+        {
+            std::cout << "ERROR: expected shared k-mer " << prefix << " to be reported\n";
+            return;
+        }
+    }
+    std::cout << "SUCCESS: k-mers spanning N are not reported\n";
+}
+
+int main()
+{
+    test_kmer_counter_N();
+    return 0;
+}
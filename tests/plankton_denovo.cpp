@@ -121,13 +121,12 @@ int main(int argc, char ** argv)
     finish = std::chrono::high_resolution_clock::now();
     runtimes.at(TIMEIT::MAP) += std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count();
 
-    std::cout << "INFO: kmers init = " << std::accumulate(locations.begin(), locations.end(), 0, [](unsigned ctr, auto & location){return ctr + location.second.first.size();}) << std::endl;
+    std::cout << "INFO: kmers init = " << locations.num_locations() << std::endl;
 
-    TReferences references;
     TKmerIDs kmerIDs;
     TSeqNoMap seqNoMap;
     start = std::chrono::high_resolution_clock::now();
-    filter_and_transform(io_cfg, locations, references, seqNoMap, kmerIDs);
+    filter_and_transform(io_cfg, primer_cfg, locations, seqNoMap, kmerIDs);
     finish = std::chrono::high_resolution_clock::now();
     runtimes.at(TIMEIT::FILTER1_TRANSFORM) += std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count();
     std::cout << "INFO: kmers after filter1 & transform = " << get_num_kmers(kmerIDs) << std::endl;
@@ -139,8 +138,8 @@ int main(int argc, char ** argv)
 
     start = std::chrono::high_resolution_clock::now();
     // template<typename TPairList>
-    // void combine(TReferences const & references, TKmerIDs const & kmerIDs, TPairList & pairs, TKmerCounts * kmerCounts = nullptr)
-    combine<TPairList>(references, kmerIDs, pairs, &kmerCounts);
+    // void combine(primer_cfg_type const & primer_cfg, TKmerIDs const & kmerIDs, TPairList & pairs, TKmerCounts * kmerCounts = nullptr, unsigned const threads = 1)
+    combine<TPairList>(primer_cfg, kmerIDs, pairs, &kmerCounts, io_cfg.get_threads());
     finish = std::chrono::high_resolution_clock::now();
     runtimes.at(TIMEIT::COMBINE_FILTER2) += std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count();
 
@@ -148,7 +147,7 @@ int main(int argc, char ** argv)
 
     std::vector<TPairFreq> pair_freqs;
     start = std::chrono::high_resolution_clock::now();
-    filter_pairs<TPairList, TPairFreqList>(io_cfg, references, kmerIDs, pairs, pair_freqs, &kmerCounts);
+    filter_pairs<TPairList, TPairFreqList>(io_cfg, kmerIDs, pairs, pair_freqs, &kmerCounts);
     std::cout << "INFO: pairs after pair_freq filter = " << kmerCounts[KMER_COUNTS::FILTER2_CNT] << std::endl;
     finish = std::chrono::high_resolution_clock::now();
     runtimes.at(TIMEIT::PAIR_FREQ) += std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count();
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <cstdlib>
@@ -213,21 +214,22 @@ void load_primers_known(std::unordered_map<TPrimerKey, std::string, hash_pp> & p
 
 // same as combine, but accepts primer pair set to be verified
 template<typename TPairList, typename TPrimerKey>
-void combine2(TReferences const & references, TKmerIDs const & kmerIDs, TPairList & pairs, std::unordered_map<TPrimerKey, std::string, hash_pp> & pairs_known, std::unordered_set<std::string> & verified)
+void combine2(TKmerIDs const & kmerIDs, TPairList & pairs, std::unordered_map<TPrimerKey, std::string, hash_pp> & pairs_known, std::unordered_set<std::string> & verified)
 {
     pairs.clear();
-    for (uint64_t seqNo = 0; seqNo < references.size(); ++seqNo)
+    for (uint64_t seqNo = 0; seqNo < kmerIDs.size(); ++seqNo)
     {
-        std::cout << "STATUS: current reference i = " << seqNo + 1 << "/" << references.size() << std::endl;
-        sdsl::bit_vector reference;
-        sdsl::util::assign(reference, references.at(seqNo));
-        sdsl::rank_support_v5<1, 1> r1s(&references.at(seqNo)); // replace after bugfix with
-        sdsl::select_support_mcl<1> s1s(&reference);
-
-        for (uint64_t r_fwd = 1; r_fwd < r1s.rank(reference.size()); ++r_fwd)
+        std::cout << "STATUS: current reference i = " << seqNo + 1 << "/" << kmerIDs.size() << std::endl;
+        // number of kmers in [0, seqPos) of reference seqNo
+        TSeqPos const * const positions = kmerIDs.positions_data(seqNo);
+        auto rank = [&](uint64_t const seqPos)
+        {
+            return uint64_t(std::lower_bound(positions, positions + kmerIDs.size(seqNo), seqPos) - positions);
+        };
+        for (uint64_t r_fwd = 1; r_fwd < kmerIDs.size(seqNo); ++r_fwd)
         {
-            uint64_t idx_fwd = s1s.select(r_fwd);  // text position of r-th k-mer
-            TKmerID const kmerID_fwd = kmerIDs[seqNo][r_fwd - 1];
+            uint64_t idx_fwd = kmerIDs.position(seqNo, r_fwd - 1);  // text position of r-th k-mer
+            TKmerID const kmerID_fwd = kmerIDs(seqNo, r_fwd - 1);
             if (!(kmerID_fwd >> CODE_SIZE))
             {
                 std::cout << "ERROR: k length pattern is zero\n";
@@ -235,9 +237,9 @@ void combine2(TReferences const & references, TKmerIDs const & kmerIDs, TPairLis
             }
 
             uint64_t w_begin = idx_fwd + PRIMER_MIN_LEN + TRANSCRIPT_MIN_LEN;
-            uint64_t w_end = std::min(reference.size(), idx_fwd + PRIMER_MAX_LEN + TRANSCRIPT_MAX_LEN + 1); // + 1: rank excludes upper bound
+            uint64_t w_end = idx_fwd + PRIMER_MAX_LEN + TRANSCRIPT_MAX_LEN + 1; // + 1: rank excludes upper bound
 
-            for (uint64_t r_rev = r1s.rank(w_begin) + 1; r_rev <= r1s.rank(w_end); ++r_rev)
+            for (uint64_t r_rev = rank(w_begin) + 1; r_rev <= rank(w_end); ++r_rev)
             {
                 TCombinePattern<TKmerID, TKmerLength> cp;
                 uint64_t mask_fwd = ONE_LSHIFT_63;
@@ -245,7 +247,7 @@ void combine2(TReferences const & references, TKmerIDs const & kmerIDs, TPairLis
                 {
                     if ((mask_fwd & kmerID_fwd)) //&& filter_CG_clamp(kmerID_fwd, '+', mask_fwd) && filter_WWW_tail(kmerID_fwd, '+', mask_fwd))
                     {
-                        TKmerID const kmerID_rev = kmerIDs.at(seqNo).at(r_rev - 1);
+                        TKmerID const kmerID_rev = kmerIDs(seqNo, r_rev - 1);
                         uint64_t mask_rev = ONE_LSHIFT_63;
                         while ((((mask_rev - 1) << 1) & kmerID_rev) >> 54)
                         {
@@ -256,7 +258,7 @@ void combine2(TReferences const & references, TKmerIDs const & kmerIDs, TPairLis
                                     TPrimerKey key{get_code(kmerID_fwd, mask_fwd) | mask_fwd, get_code(kmerID_rev, mask_rev) | mask_rev};
                                     if (pairs_known.find(key) != pairs_known.end())
                                     {
-                                        std::cout << "INFO: primer pair <" << pairs_known[key] << "> found for refID = " << seqNo << " at " << s1s.select(r_fwd) << " and " << s1s.select(r_rev) << std::endl;
+                                        std::cout << "INFO: primer pair <" << pairs_known[key] << "> found for refID = " << seqNo << " at " << kmerIDs.position(seqNo, r_fwd - 1) << " and " << kmerIDs.position(seqNo, r_rev - 1) << std::endl;
                                         verified.insert(pairs_known[key]);
                                     }
                                 }
@@ -316,14 +318,13 @@ int main(int argc, char ** argv)
 
     // compute k-mer mappings
     fm_map(io_cfg, primer_cfg, locations);
-    auto kmer_cnt = std::accumulate(locations.begin(), locations.end(), 0, [](unsigned ctr, auto & location){return ctr + location.second.first.size();});
+    auto kmer_cnt = locations.num_locations();
     std::cout << "INFO: kmers init = " << kmer_cnt << std::endl;
     if (!kmer_cnt)
         exit(0);
-    TReferences references;
     TKmerIDs kmerIDs;
     TSeqNoMap seqNoMap;
-    filter_and_transform(io_cfg, locations, references, seqNoMap, kmerIDs, &kmerCounts);
+    filter_and_transform(io_cfg, primer_cfg, locations, seqNoMap, kmerIDs);
     std::cout << "INFO: kmers after filter1 & transform = " << get_num_kmers(kmerIDs) << std::endl;
 
     // TODO: delete locations
@@ -332,7 +333,7 @@ int main(int argc, char ** argv)
 
     std::unordered_set<std::string> verified;
 
-    combine2<TPairList, TPrimerKey>(references, kmerIDs, pairs, pairs_known, verified);
+    combine2<TPairList, TPrimerKey>(kmerIDs, pairs, pairs_known, verified);
     std::cout << "INFO: pairs after combiner = " << get_num_pairs<TPairList>(pairs) << std::endl;
 
     std::cout << "Verified primers for current clade: \n";
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+#include "../src/combine_types.hpp"
+#include "../src/filter.hpp"
+#include "../src/primer_cfg_type.hpp"
+#include "../src/types.hpp"
+#include "../src/utilities.hpp"
+
+using namespace priset;
+
+// Transform and combine with the kernels for primer lengths [18:22] selected by
+// primer_length_apply have to equal the kernels of the full range, which are used
+// for ranges without instantiated kernels, on the same length masks.
+// g++ ../PriSeT/tests/primer_length_test.cpp -Wno-write-strings -std=c++17 -Wall -Wextra -lstdc++fs -pthread -DNDEBUG -O3 -I/Users/troja/include -L/Users/troja/lib -lsdsl -ldivsufsort -I .. -o primer_length_test
+
+using TPairs = TPairList<TPair<TCombinePattern<TKmerID, TKmerLength>>>;
+
+#define REFERENCES 8
+#define REFERENCE_LENGTH 5000
+
+/*
+ * Random references and k-mer locations of all lengths in [PRIMER_MIN_LEN:PRIMER_MAX_LEN]
+ * as emitted by the mapper, registered by filter_locations with the lengths of primer_cfg.
+ * A k-mer occurs at most twice per reference, close occurrences are dropped by the
+ * trap distance.
+ */
+void random_masks(primer_cfg_type const & primer_cfg, seqan::StringSet<seqan::Dna5String> & text, TLengthMasks & masks)
+{
+    std::mt19937_64 generator(42);
+    for (uint64_t seqNo = 0; seqNo < REFERENCES; ++seqNo)
+    {
+        std::string seq;
+        for (uint64_t i = 0; i < REFERENCE_LENGTH; ++i)
+            seq.push_back("ACGT"[generator() % 4]);
+        seqan::appendValue(text, seqan::Dna5String(seq));
+    }
+    for (TKmerLength K = PRIMER_MIN_LEN; K <= PRIMER_MAX_LEN; ++K)
+    {
+        for (uint64_t kmer = 0; kmer < 400; ++kmer)
+        {
+            std::vector<TLocation> locs;
+            for (TSeqNo seqNo = 0; seqNo < REFERENCES; ++seqNo)
+            {
+                std::vector<TSeqPos> seqPos{TSeqPos(generator() % (REFERENCE_LENGTH - PRIMER_MAX_LEN)), TSeqPos(generator() % (REFERENCE_LENGTH - PRIMER_MAX_LEN))};
+                std::sort(seqPos.begin(), seqPos.end());
+                for (uint64_t i = generator() % 3; i < seqPos.size(); ++i)
+                    locs.push_back(TLocation{seqNo, seqPos[i]});
+            }
+            filter_locations(primer_cfg, K, locs, masks);
+        }
+    }
+}
+
+// True if both transforms yield the same kmerIDs at the same positions.
+bool equal_kmerIDs(TKmerIDs const & lhs, TKmerIDs const & rhs)
+{
+    if (lhs.size() != rhs.size() || lhs.num_kmerIDs() != rhs.num_kmerIDs())
+        return false;
+    for (uint64_t seqNo_cx = 0; seqNo_cx < lhs.size(); ++seqNo_cx)
+    {
+        if (lhs.size(seqNo_cx) != rhs.size(seqNo_cx))
+            return false;
+        for (uint64_t i = 0; i < lhs.size(seqNo_cx); ++i)
+        {
+            if (lhs(seqNo_cx, i) != rhs(seqNo_cx, i) || lhs.position(seqNo_cx, i) != rhs.position(seqNo_cx, i))
+                return false;
+        }
+    }
+    return true;
+}
+
+// True if both combiners yield the same pairs with the same length combinations.
+bool equal_pairs(TPairs const & lhs, TPairs const & rhs)
+{
+    if (lhs.size() != rhs.size())
+        return false;
+    for (uint64_t i = 0; i < lhs.size(); ++i)
+    {
+        if (lhs[i].reference != rhs[i].reference || lhs[i].r_fwd != rhs[i].r_fwd || lhs[i].r_rev != rhs[i].r_rev ||
+            lhs[i].cp.to_string() != rhs[i].cp.to_string())
+            return false;
+    }
+    return true;
+}
+
+int main()
+{
+    primer_cfg_type primer_cfg{};
+    primer_cfg.set_primer_length(18, 22);
+    seqan::StringSet<seqan::Dna5String> text;
+    TLengthMasks masks;
+    random_masks(primer_cfg, text, masks);
+    TLengthMasks masks_full{masks};
+    unsigned const threads = 2;
+
+    // kernels for [18:22]
+    bool specialized{0};
+    TSeqNoMap seqNoMap;
+    TKmerIDs kmerIDs;
+    TPairs pairs;
+    primer_length_apply(primer_cfg, [&](auto lengths)
+    {
+        specialized = std::is_same<decltype(lengths), TPrimerLengths<18, 22> >::value;
+        transform<decltype(lengths)>(text, masks, primer_cfg, threads, seqNoMap, kmerIDs);
+    });
+    combine(primer_cfg, kmerIDs, pairs, nullptr, threads);
+
+    // kernels for the full range
+    TSeqNoMap seqNoMap_full;
+    TKmerIDs kmerIDs_full;
+    TPairs pairs_full;
+    transform<TPrimerLengthsFull>(text, masks_full, primer_cfg, threads, seqNoMap_full, kmerIDs_full);
+    combine_kernel<TPrimerLengthsFull>(primer_cfg, kmerIDs_full, pairs_full, nullptr, threads);
+
+    if (!specialized)
+    {
+        std::cout << "ERROR: expect kernels for [18:22] from primer_length_apply\n";
+        return EXIT_FAILURE;
+    }
+    if (!kmerIDs.num_kmerIDs() || pairs.empty())
+    {
+        std::cout << "ERROR: expect kmers and pairs passing the filters\n";
+        return EXIT_FAILURE;
+    }
+    for (TKmerID const kmerID : kmerIDs)
+    {
+        if (kmerID & PREFIX_SELECTOR & ~TPrimerLengths<18, 22>::SELECTOR)
+        {
+            std::cout << "ERROR: length bits outside of [18:22] in " << kmerID2str(kmerID) << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (!equal_kmerIDs(kmerIDs, kmerIDs_full))
+    {
+        std::cout << "ERROR: transform with kernels for [18:22] differs from the full range\n";
+        return EXIT_FAILURE;
+    }
+    if (!equal_pairs(pairs, pairs_full))
+    {
+        std::cout << "ERROR: combine with kernels for [18:22] differs from the full range\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "SUCCESS: " << kmerIDs.num_kmerIDs() << " kmers and " << pairs.size() << " pairs equal for both kernels\n";
+    return 0;
+}
@@ -98,10 +98,9 @@ int main(/*int argc, char ** argv*/)
 
     std::cout << "INFO: kmers init = " << locations.size() << std::endl;
 
-    TReferences references;
     TKmerIDs kmerIDs;
     TSeqNoMap seqNoMap;
-    filter_and_transform(io_cfg, locations, references, kmerIDs, seqNoMap, kmerCounts);
+    filter_and_transform(io_cfg, primer_cfg, locations, seqNoMap, kmerIDs);
 
     std::cout << "INFO: kmers after filter1 & transform = " << get_num_kmers(kmerIDs) << std::endl;
 
@@ -109,9 +108,10 @@ int main(/*int argc, char ** argv*/)
     using TPairList = TPairList<TPair<TCombinePattern<TKmerID, TKmerLength>>>;
     TPairList pairs;
 
-    combine<TPairList>(references, kmerIDs, pairs, kmerCounts);
+    combine<TPairList>(primer_cfg, kmerIDs, pairs, &kmerCounts);
 
-    filter_pairs(io_cfg, references, kmerIDs, pairs);
+    TPairFreqList pair_freqs;
+    filter_pairs(io_cfg, kmerIDs, pairs, pair_freqs, &kmerCounts);
 
     std::cout << "INFO: pairs after frequency cutoff = " << get_num_pairs<TPairList>(pairs) << std::endl;
 
@@ -122,8 +122,8 @@ int main(/*int argc, char ** argv*/)
         uint idx = std::rand() % pairs.size();
         std::cout << "sampled pair index: " << idx << std::endl;
         TPair<TCombinePattern<TKmerID, TKmerLength>> pair = pairs.at(idx);
-        TKmerID kmer_fwd = kmerIDs[pair.reference][pair.r_fwd];
-        TKmerID kmer_rev = kmerIDs[pair.reference][pair.r_rev];
+        TKmerID kmer_fwd = kmerIDs(pair.reference, pair.r_fwd);
+        TKmerID kmer_rev = kmerIDs(pair.reference, pair.r_rev);
         if (pair.cp.none())
         {
             std::cout << "ERROR: no bit set in combination bitset!\n";
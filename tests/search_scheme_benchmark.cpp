@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <experimental/filesystem>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <seqan/basic.h>
+
+#include "../src/argument_parser.hpp"
+#include "../src/errors.hpp"
+#include "../src/fm.hpp"
+#include "../src/io_cfg_type.hpp"
+#include "../src/location_store.hpp"
+#include "../src/primer_cfg_type.hpp"
+#include "../src/search_schemes.hpp"
+#include "../src/types.hpp"
+
+namespace fs = std::experimental::filesystem;
+using namespace priset;
+
+// Compare k-mer mapping runtimes for E = 0, 1, 2 of the baseline, which runs genmap's
+// mappabilityMain once per K, and of the single traversal with approximate matches
+// extended along the traversal and found by optimum search schemes. All have to
+// report the same k-mer groups with identical locations. Use the runtimes to set
+// SEARCH_SCHEME_MIN_ERRORS in fm.hpp.
+// g++ ../PriSeT/tests/search_scheme_benchmark.cpp -Wno-write-strings -std=c++17 -Wall -Wextra -lstdc++fs -Wno-unknown-pragmas -pthread -DNDEBUG -O3 -I/Users/troja/include -L/Users/troja/lib -lsdsl -ldivsufsort -o search_scheme_benchmark
+// ./search_scheme_benchmark ../PriSeT/tests/library/131221 ../PriSeT/tests/work/131221
+
+using TIter = seqan::Iter<TIndex, seqan::VSTree<seqan::TopDown<>>>;
+
+// K and locations of a k-mer group, mapped to the exact occurrences reported as its keys.
+using TBaselineGroups = std::map<std::pair<TKmerLength, std::vector<TLocation> >, std::vector<TLocation> >;
+
+// Run baseline mapping with genmap for each K and return runtime in ms.
+size_t time_baseline(io_cfg_type const & io_cfg, unsigned const freq_kmer_min, uint8_t const E, TBaselineGroups & groups)
+{
+    std::string const index_dir = io_cfg.get_index_dir().string();
+    std::string const mapping_dir = io_cfg.get_mapping_dir().string();
+    std::string const errors = std::to_string(E);
+    TLocations loc_per_K;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (auto K = PRIMER_MIN_LEN; K <= PRIMER_MAX_LEN; ++K)
+    {
+        std::string const length = std::to_string(K);
+        // csv flag triggers `csvComputation` and therefore the population of loc_per_K
+        char const * argv[11] = {"map", "-I", index_dir.c_str(), "-O", mapping_dir.c_str(), "-K", length.c_str(), "-E", errors.c_str(), "--csvRAM", "-fl"};
+        loc_per_K.clear();
+        mappabilityMain<TLocations>(11, argv, loc_per_K, freq_kmer_min);
+        for (auto const & [key, value] : loc_per_K)
+        {
+            std::vector<TLocation> locs = value.first;
+            std::sort(locs.begin(), locs.end());
+            groups[{TKmerLength(K), locs}].push_back(key);
+        }
+    }
+    auto finish = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(finish - start).count();
+}
+
+// Run mapping traversal and return runtime in ms.
+size_t time_mapping(TIndex & index, unsigned const freq_kmer_min, uint8_t const E, bool const with_scheme, TKLocations & locations)
+{
+    TMapParams<TIter> params{TIter(index), E, freq_kmer_min, PRIMER_MIN_LEN, PRIMER_MAX_LEN, {}};
+    if (with_scheme)
+        params.steps = search_scheme_steps(search_scheme(E), PRIMER_MIN_LEN);
+    TMatchSet<TIter> root{{params.root, 0}};
+    std::string kmer;
+    auto start = std::chrono::high_resolution_clock::now();
+    fm_map_extend(root, 0, kmer, params, locations);
+    locations.sort();
+    auto finish = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(finish - start).count();
+}
+
+// Return locations of a k-mer group as vector.
+std::vector<TLocation> group_locations(TKLocations const & locations, uint64_t const i)
+{
+    TLocationRange const range = locations.group_locations(locations.group(i));
+    std::vector<TLocation> locs;
+    for (uint64_t j = 0; j < range.size(); ++j)
+        locs.push_back(range[j]);
+    return locs;
+}
+
+// True if both traversals report the same keys and groups, locations are compared one by one.
+bool equal_locations(TKLocations const & lhs, TKLocations const & rhs)
+{
+    if (lhs.size() != rhs.size() || lhs.num_locations() != rhs.num_locations())
+        return false;
+    for (uint64_t i = 0; i < lhs.size(); ++i)
+    {
+        if (lhs.key(i) != rhs.key(i) || group_locations(lhs, i) != group_locations(rhs, i))
+            return false;
+    }
+    return true;
+}
+
+/*
+ * True if the traversal reports the k-mer groups of the baseline. The baseline has
+ * a key for each exact occurrence, hence the distinct (K, locations) pairs have to
+ * be equal one by one and the representative of each group has to be one of the
+ * keys of its pair.
+ */
+bool equal_locations(TBaselineGroups const & baseline, TKLocations const & locations)
+{
+    TBaselineGroups groups;
+    for (uint64_t i = 0; i < locations.size(); ++i)
+    {
+        auto const [seqNo, seqPos, K] = locations.key(i);
+        groups[{K, group_locations(locations, i)}].push_back(TLocation{seqNo, seqPos});
+    }
+    if (groups.size() != baseline.size())
+        return false;
+    for (auto it = groups.begin(), it_baseline = baseline.begin(); it != groups.end(); ++it, ++it_baseline)
+    {
+        if (it->first != it_baseline->first || it->second.size() > it_baseline->second.size())
+            return false;
+        for (TLocation const & key : it->second)
+        {
+            if (std::find(it_baseline->second.begin(), it_baseline->second.end(), key) == it_baseline->second.end())
+                return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char ** argv)
+{
+    if (argc != 3)
+    {
+        std::cout << "Give paths to lib and work dirs.\n";
+        exit(-1);
+    }
+    unsigned const priset_argc = 5;
+    char * const priset_argv[priset_argc] = {"priset", "-l", argv[1], "-w", argv[2]};
+
+    io_cfg_type io_cfg{};
+    primer_cfg_type primer_cfg{};
+    options opt(priset_argc, priset_argv, primer_cfg, io_cfg);
+    // TIndex is the default flavour
+    io_cfg.set_index_bwt_width(64);
+
+    int ret_code;
+    if ((ret_code = fm_index(io_cfg)))
+    {
+        std::cout << "ERROR: " << ret_code << std::endl;
+        exit(-1);
+    }
+    TIndex index;
+    fm_load(io_cfg, index);
+    unsigned const freq_kmer_min = io_cfg.get_freq_kmer_min();
+
+    bool success = true;
+    std::cout << "E\tbaseline [ms]\textend [ms]\tscheme [ms]\tgroups\tlocations\n" << std::string(76, '_') << "\n";
+    for (uint8_t E : {0, 1, 2})
+    {
+        TBaselineGroups baseline;
+        size_t const runtime_baseline = time_baseline(io_cfg, freq_kmer_min, E, baseline);
+        TKLocations locations_extend(seqan::length(seqan::indexText(index))), locations_scheme(seqan::length(seqan::indexText(index)));
+        size_t const runtime_extend = time_mapping(index, freq_kmer_min, E, false, locations_extend);
+        success &= equal_locations(baseline, locations_extend);
+        std::cout << int(E) << '\t' << runtime_baseline << "\t\t" << runtime_extend << "\t\t";
+        if (E)
+        {
+            std::cout << time_mapping(index, freq_kmer_min, E, true, locations_scheme);
+            success &= equal_locations(locations_extend, locations_scheme);
+        }
+        else
+            std::cout << "-";
+        std::cout << "\t\t" << locations_extend.size() << '\t' << locations_extend.num_locations() << std::endl;
+    }
+    if (!success)
+    {
+        std::cout << "ERROR: baseline, extension and search schemes report different k-mers\n";
+        return EXIT_FAILURE;
+    }
+    std::cout << "SUCCESS: baseline, extension and search schemes report the same k-mers\n";
+    return 0;
+}